@@ -0,0 +1,101 @@
+#include "aliasindex.h"
+
+#include "debug.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <initializer_list>
+#include <list>
+#include <sys/stat.h>
+
+using namespace std;
+
+/* Number of alias files whose index is kept after their selector closed. */
+static const size_t MAX_CACHED = 4;
+
+typedef pair<StrRef, StrRef> Alias;
+
+static bool keyLess(const Alias &a, const Alias &b)
+{
+	int diff = memcmp(a.first.data(), b.first.data(),
+				min(a.first.size(), b.first.size()));
+	return diff ? diff < 0 : a.first.size() < b.first.size();
+}
+
+AliasIndex::AliasIndex(const string &path)
+{
+	ConfReader reader(path);
+	StrRef name, value;
+	size_t total = 0;
+	while (reader.next(name, value)) {
+		entries.emplace_back(name, value);
+		total += name.size() + value.size();
+	}
+
+	// Move the ranges out of the mapping, which goes away with "reader".
+	text.reset(new char[total]);
+	char *pos = text.get();
+	for (auto &entry : entries) {
+		for (StrRef *ref : { &entry.first, &entry.second }) {
+			memcpy(pos, ref->data(), ref->size());
+			*ref = StrRef(pos, ref->size());
+			pos += ref->size();
+		}
+	}
+
+	/* Stable, so that the last of several entries with the same name can
+	 * win, as it did when the file was read into a map. Alias files are
+	 * usually generated in order already. */
+	if (!is_sorted(entries.begin(), entries.end(), keyLess))
+		stable_sort(entries.begin(), entries.end(), keyLess);
+}
+
+string AliasIndex::lookup(const string &name) const
+{
+	Alias key(StrRef(name.data(), name.size()), StrRef());
+	auto it = upper_bound(entries.begin(), entries.end(), key, keyLess);
+	if (it == entries.begin() || (it - 1)->first != key.first)
+		return "";
+	return (it - 1)->second.str();
+}
+
+shared_ptr<const AliasIndex> AliasIndex::get(const string &path)
+{
+	struct Cached {
+		string path;
+		struct timespec mtime;
+		off_t size;
+		shared_ptr<const AliasIndex> index;
+	};
+	static list<Cached> cache; // most recently used first
+
+	struct stat st;
+	if (stat(path.c_str(), &st)) {
+		WARNING("Unable to open alias file %s\n", path.c_str());
+		return nullptr;
+	}
+
+	for (auto it = cache.begin(); it != cache.end(); ++it) {
+		if (it->path != path)
+			continue;
+
+		if (it->mtime.tv_sec == st.st_mtim.tv_sec
+					&& it->mtime.tv_nsec == st.st_mtim.tv_nsec
+					&& it->size == st.st_size) {
+			cache.splice(cache.begin(), cache, it);
+			return it->index;
+		}
+		cache.erase(it);
+		break;
+	}
+
+	shared_ptr<const AliasIndex> index(new AliasIndex(path));
+	DEBUG("Indexed %u aliases of %s\n",
+				(unsigned int) index->size(), path.c_str());
+
+	cache.push_front({ path, st.st_mtim, st.st_size, index });
+	if (cache.size() > MAX_CACHED)
+		cache.pop_back();
+	return index;
+}
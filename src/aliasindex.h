@@ -0,0 +1,41 @@
+#ifndef ALIASINDEX_H
+#define ALIASINDEX_H
+
+#include "confreader.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * The aliases of a selector alias file ("name=title" per line), indexed
+ * for lookups one name at a time.
+ *
+ * The names and aliases are copied into a single buffer, which the index
+ * holds sorted ranges of, so even lists with tens of thousands of entries
+ * are loaded without allocating a string per entry. The file itself is
+ * closed once indexed, so it never keeps the card busy. Indexes are shared
+ * by path, and reused for as long as the file is not modified.
+ */
+class AliasIndex {
+public:
+	/**
+	 * Returns the index of the alias file at "path", or NULL if it cannot
+	 * be read.
+	 */
+	static std::shared_ptr<const AliasIndex> get(const std::string &path);
+
+	/** Returns the alias of "name", or an empty string if there is none. */
+	std::string lookup(const std::string &name) const;
+
+	size_t size() const { return entries.size(); }
+
+	AliasIndex(const std::string &path);
+
+private:
+	std::unique_ptr<char[]> text;
+	std::vector<std::pair<StrRef, StrRef>> entries;
+};
+
+#endif
@@ -22,6 +22,7 @@ public:
 	virtual void paint(Surface &s);
 	virtual bool handleButtonPress(InputManager::Button button);
 	virtual bool handleTouchscreen(Touchscreen &ts);
+	virtual const char *getName() { return "Background"; }
 
 private:
 	GMenu2X &gmenu2x;
@@ -3,10 +3,12 @@
 #include "filelister.h"
 #include "gmenu2x.h"
 #include "iconbutton.h"
+#include "latencytrace.h"
 #include "surface.h"
 #include "utilities.h"
 
 using std::string;
+using std::tie;
 
 BrowseDialog::BrowseDialog(
 		GMenu2X *gmenu2x, Touchscreen &ts_,
@@ -15,6 +17,7 @@ BrowseDialog::BrowseDialog(
 	, ts(ts_)
 	, title(title)
 	, subtitle(subtitle)
+	, list(gmenu2x)
 	, ts_pressed(false)
 	, buttonBox(gmenu2x)
 {
@@ -40,14 +43,32 @@ BrowseDialog::BrowseDialog(
 	iconGoUp = gmenu2x->sc.skinRes("imgs/go-up.png");
 	iconFolder = gmenu2x->sc.skinRes("imgs/folder.png");
 	iconFile = gmenu2x->sc.skinRes("imgs/file.png");
+
+	list.setLabels([this](unsigned int i) { return (*fl)[i]; });
+	list.setIcons([this](unsigned int i) {
+		if (!fl->isDirectory(i))
+			return iconFile;
+		return (*fl)[i] == ".." ? iconGoUp : iconFolder;
+	});
 }
 
 BrowseDialog::~BrowseDialog()
 {
 }
 
+void BrowseDialog::setPath(const string &path)
+{
+	fl->setPath(path);
+	list.setSize(fl->size());
+	list.setSelected(0);
+	list.invalidate();
+	onChangeDir();
+}
+
 bool BrowseDialog::exec()
 {
+	LatencyTrace::Scope scope("BrowseDialog");
+
 	if (!fl)
 		return false;
 
@@ -58,24 +79,21 @@ bool BrowseDialog::exec()
 
 	fl->browse();
 
-	const int topBarHeight = gmenu2x->skinConfInt["topBarHeight"];
-	rowHeight = gmenu2x->font->getHeight() + 1; // gp2x=15+1 / pandora=19+1
+	unsigned int top, height;
+	tie(top, height) = gmenu2x->getContentArea();
+	unsigned int rowHeight = gmenu2x->font->getHeight() + 1; // gp2x=15+1 / pandora=19+1
 	rowHeight = constrain(rowHeight, 20, 40);
-	numRows = (gmenu2x->resY - topBarHeight - 20) / rowHeight;
-	clipRect = (SDL_Rect) {
+	touchRect = (SDL_Rect) {
 		0,
-		static_cast<Sint16>(topBarHeight + 1),
+		static_cast<Sint16>(top),
 		static_cast<Uint16>(gmenu2x->resX - 9),
-		static_cast<Uint16>(gmenu2x->resY - topBarHeight - 25)
-	};
-	touchRect = (SDL_Rect) {
-		2,
-		static_cast<Sint16>(topBarHeight + 4),
-		static_cast<Uint16>(gmenu2x->resX - 12),
-		clipRect.h
+		static_cast<Uint16>(height)
 	};
+	list.setArea(touchRect, rowHeight);
+	list.setSize(fl->size());
+	list.setSelected(0);
+	list.invalidate();
 
-	selected = 0;
 	close = false;
 	while (!close) {
 		if (ts.available()) ts.poll();
@@ -129,6 +147,7 @@ void BrowseDialog::handleInput()
 		ts_pressed = false;
 	}
 
+	const unsigned int selected = list.getSelected();
 	if (action == BrowseDialog::ACT_SELECT && (*fl)[selected] == "..") {
 		action = BrowseDialog::ACT_GOUP;
 	}
@@ -137,28 +156,18 @@ void BrowseDialog::handleInput()
 		quit();
 		break;
 	case BrowseDialog::ACT_UP:
-		if (selected == 0)
-			selected = fl->size() - 1;
-		else
-			selected -= 1;
+		list.up();
 		break;
 	case BrowseDialog::ACT_SCROLLUP:
-		if (selected <= numRows - 2)
-			selected = 0;
-		else
-			selected -= numRows - 2;
+		list.setSelected(fl->prevLetter(selected));
+		showLetterOverlay(fl->getLetter(list.getSelected()));
 		break;
 	case BrowseDialog::ACT_DOWN:
-		if (fl->size() - 1 <= selected)
-			selected = 0;
-		else
-			selected += 1;
+		list.down();
 		break;
 	case BrowseDialog::ACT_SCROLLDOWN:
-		if (selected+(numRows-2)>=fl->size())
-			selected = fl->size()-1;
-		else
-			selected += numRows-2;
+		list.setSelected(fl->nextLetter(selected));
+		showLetterOverlay(fl->getLetter(list.getSelected()));
 		break;
 	case BrowseDialog::ACT_GOUP:
 		directoryUp();
@@ -193,7 +202,6 @@ void BrowseDialog::directoryUp()
 	if (p == string::npos || path.compare(0, 1, "/") != 0 || path.length() < 2) {
 		quit();
 	} else {
-		selected = 0;
 		setPath(path.substr(0, p));
 	}
 }
@@ -205,9 +213,7 @@ void BrowseDialog::directoryEnter()
 		path += "/";
 	}
 
-	setPath(path + fl->at(selected));
-
-	selected = 0;
+	setPath(path + fl->at(list.getSelected()));
 }
 
 void BrowseDialog::confirm()
@@ -222,69 +228,31 @@ void BrowseDialog::quit()
 	close = true;
 }
 
-void BrowseDialog::paint()
+void BrowseDialog::paintChrome(Surface *s)
 {
-	unsigned int i, iY;
-	unsigned int firstElement, lastElement;
-	unsigned int offsetY;
-
-	Surface bg(gmenu2x->bg);
-	drawTitleIcon("icons/explorer.png", true, &bg);
-	writeTitle(title, &bg);
-	writeSubTitle(subtitle, &bg);
-	buttonBox.paint(&bg, 5);
-
-	bg.convertToDisplayFormat();
-	bg.blit(gmenu2x->s,0,0);
-
-	// TODO(MtH): I have no idea what the right value of firstElement would be,
-	//            but originally it was undefined and that is never a good idea.
-	firstElement = 0;
-	if (selected>firstElement+numRows - 1) {
-		firstElement = selected-numRows + 1;
-	} else if (selected < firstElement) {
-		firstElement = selected;
-	}
-
-	//Selection
-	const int topBarHeight = gmenu2x->skinConfInt["topBarHeight"];
-	iY = topBarHeight + 1 + (selected - firstElement) * rowHeight;
-	gmenu2x->s->box(2, iY, gmenu2x->resX - 12, rowHeight - 1,
-			gmenu2x->skinConfColors[COLOR_SELECTION_BG]);
-
-	lastElement = firstElement + numRows;
-	if (lastElement > fl->size())
-		lastElement = fl->size();
-
-	offsetY = topBarHeight + 1;
+	drawTitleIcon("icons/explorer.png", true, s);
+	writeTitle(title, s);
+	writeSubTitle(subtitle, s);
+	buttonBox.paint(s, 5);
+}
 
-	//Files & Directories
-	gmenu2x->s->setClipRect(clipRect);
-	for (i = firstElement; i < lastElement; i++) {
-		Surface *icon;
-		if (fl->isDirectory(i)) {
-			if ((*fl)[i] == "..") {
-				icon = iconGoUp;
-			} else {
-				icon = iconFolder;
-			}
-		} else {
-			icon = iconFile;
-		}
-		icon->blit(gmenu2x->s, 5, offsetY);
-		gmenu2x->s->write(gmenu2x->font, (*fl)[i], 24, offsetY + rowHeight / 2,
-				Font::HAlignLeft, Font::VAlignMiddle);
+void BrowseDialog::paint()
+{
+	getChrome()->blit(gmenu2x->s,0,0);
 
-		if (ts.available() && ts.pressed()
-				&& ts.inRect(touchRect.x, offsetY + 3, touchRect.w, rowHeight)) {
+	if (ts.available() && ts.pressed()) {
+		int row = list.rowAt(ts.getX(), ts.getY());
+		if (row >= 0) {
 			ts_pressed = true;
-			selected = i;
+			list.setSelected(row);
 		}
-
-		offsetY += rowHeight;
 	}
-	gmenu2x->s->clearClipRect();
 
-	gmenu2x->drawScrollBar(numRows,fl->size(), firstElement);
+	beforeFileList();
+
+	//Files & Directories
+	list.paint(gmenu2x->s);
+
+	paintLetterOverlay();
 	gmenu2x->s->flip();
 }
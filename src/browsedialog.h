@@ -25,6 +25,7 @@
 #include "dialog.h"
 #include "filelister.h"
 #include "inputmanager.h"
+#include "listview.h"
 
 #include <SDL.h>
 #include <string>
@@ -38,12 +39,16 @@ protected:
 			const std::string &title, const std::string &subtitle);
 	virtual ~BrowseDialog();
 
-	void setPath(const std::string &path) {
-		fl->setPath(path);
-	}
+	void setPath(const std::string &path);
+
+	unsigned int getSelected() { return list.getSelected(); }
+
+	/** Called on every frame, before the list is painted over the chrome. */
+	virtual void beforeFileList() {}
+	/** Called after another directory was opened. */
+	virtual void onChangeDir() {}
 
 	FileLister *fl;
-	unsigned int selected;
 
 private:
 	enum Action {
@@ -64,12 +69,9 @@ private:
 	std::string title;
 	std::string subtitle;
 
-	SDL_Rect clipRect;
+	ListView list;
 	SDL_Rect touchRect;
 
-	unsigned int numRows;
-	unsigned int rowHeight;
-
 	bool ts_pressed;
 
 	Surface *iconGoUp;
@@ -81,6 +83,7 @@ private:
 	Action getAction(InputManager::Button button);
 	void handleInput();
 
+	virtual void paintChrome(Surface *s);
 	void paint();
 
 	void directoryUp();
@@ -95,7 +98,7 @@ public:
 		return fl->getPath();
 	}
 	std::string getFile() {
-		return (*fl)[selected];
+		return (*fl)[getSelected()];
 	}
 };
 
@@ -0,0 +1,135 @@
+#include "collation.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+typedef pair<string, string> KeyedName;
+
+/* ASCII only, like strcasecmp() in the C locale; and cheaper than the
+ * <cctype> functions, which have to check the current locale. */
+static inline bool isDigit(unsigned char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline char foldCase(unsigned char c)
+{
+	return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+string collationKey(const string &str, bool natural)
+{
+	string key;
+	key.reserve(str.size() + 4);
+
+	for (size_t i = 0; i < str.size(); ) {
+		unsigned char c = str[i];
+		if (!natural || !isDigit(c)) {
+			key += foldCase(c);
+			i++;
+			continue;
+		}
+
+		/* Drop the leading zeros, but keep a lone "0". */
+		while (str[i] == '0' && i + 1 < str.size()
+					&& isDigit(str[i + 1]))
+			i++;
+		size_t start = i;
+		while (i < str.size() && isDigit(str[i]))
+			i++;
+
+		/* Prefix the digits with their count, so that longer numbers sort
+		 * after shorter ones. The count is written with digits only, in
+		 * an order-preserving way ("5", "9" "0", "9" "3", "9" "9" "0"...):
+		 * a number still sorts like a digit relative to other characters. */
+		size_t len = i - start;
+		for (; len >= 9; len -= 9)
+			key += '9';
+		key += (char) ('0' + len);
+		key.append(str, start, i - start);
+	}
+
+	return key;
+}
+
+bool collation_less::operator()(const string &left, const string &right) const
+{
+	int diff = collationKey(left).compare(collationKey(right));
+	return diff ? diff < 0 : left < right;
+}
+
+static vector<KeyedName> keyed(vector<string> &names)
+{
+	vector<KeyedName> result;
+	result.reserve(names.size());
+	for (auto &name : names) {
+		string key = collationKey(name);
+		result.emplace_back(std::move(key), std::move(name));
+	}
+	return result;
+}
+
+void collationSort(vector<string> &names)
+{
+	/* Sort the keys along with the position of their name, which is
+	 * cheaper to move around than the name itself. */
+	vector<pair<string, size_t>> order;
+	order.reserve(names.size());
+	for (size_t i = 0; i < names.size(); i++)
+		order.emplace_back(collationKey(names[i]), i);
+
+	sort(order.begin(), order.end(),
+		[&names](const pair<string, size_t> &a, const pair<string, size_t> &b) {
+			int diff = a.first.compare(b.first);
+			return diff ? diff < 0 : names[a.second] < names[b.second];
+		});
+
+	vector<string> sorted;
+	sorted.reserve(names.size());
+	for (auto &it : order)
+		sorted.push_back(std::move(names[it.second]));
+	names.swap(sorted);
+}
+
+void collationMerge(vector<string> &names, vector<string> &keys,
+		vector<string> &batch, bool batchSorted)
+{
+	if (keys.size() != names.size()) {
+		keys.clear();
+		keys.reserve(names.size());
+		for (auto &name : names)
+			keys.push_back(collationKey(name));
+	}
+
+	vector<KeyedName> added = keyed(batch);
+	batch.clear();
+	if (!batchSorted)
+		sort(added.begin(), added.end());
+
+	vector<string> mergedNames, mergedKeys;
+	mergedNames.reserve(names.size() + added.size());
+	mergedKeys.reserve(names.size() + added.size());
+
+	size_t i = 0, j = 0;
+	while (i < names.size() || j < added.size()) {
+		bool takeOld = j == added.size();
+		if (!takeOld && i < names.size()) {
+			int diff = keys[i].compare(added[j].first);
+			takeOld = diff < 0 || (!diff && names[i] < added[j].second);
+		}
+		if (takeOld) {
+			mergedNames.push_back(std::move(names[i]));
+			mergedKeys.push_back(std::move(keys[i]));
+			i++;
+		} else {
+			mergedNames.push_back(std::move(added[j].second));
+			mergedKeys.push_back(std::move(added[j].first));
+			j++;
+		}
+	}
+
+	names.swap(mergedNames);
+	keys.swap(mergedKeys);
+}
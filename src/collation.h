@@ -0,0 +1,40 @@
+#ifndef COLLATION_H
+#define COLLATION_H
+
+#include <string>
+#include <vector>
+
+/**
+ * Returns a key that sorts like "str" should be shown to the user: ASCII
+ * letters are case-folded and, if "natural" is set, runs of digits compare
+ * by their numeric value, so that "Game 2" comes before "Game 10".
+ *
+ * Keys are compared as plain strings: folding a name once into its key is
+ * much cheaper than folding it again in every comparison of a sort.
+ */
+std::string collationKey(const std::string &str, bool natural = true);
+
+/**
+ * Compares two names by their collation keys, falling back to the names
+ * themselves for names with equal keys. This computes both keys on every
+ * call; prefer collationSort() and collationMerge() for whole lists.
+ */
+struct collation_less {
+	bool operator()(const std::string &left, const std::string &right) const;
+};
+
+/** Sorts "names" in collation order, computing the key of each name once. */
+void collationSort(std::vector<std::string> &names);
+
+/**
+ * Merges "batch" into "names", which is in collation order and whose keys
+ * are in "keys" (computed here if "keys" is empty). Only the keys of the
+ * new names are computed, and the result is kept in "keys" for the next
+ * merge. "batch" is sorted first unless "batchSorted" is set; it is left
+ * empty.
+ */
+void collationMerge(std::vector<std::string> &names,
+		std::vector<std::string> &keys, std::vector<std::string> &batch,
+		bool batchSorted);
+
+#endif
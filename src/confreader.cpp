@@ -0,0 +1,118 @@
+#include "confreader.h"
+
+#include "debug.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+size_t StrRef::find(char c) const
+{
+	const void *p = memchr(ptr, c, len);
+	return p ? (const char *) p - ptr : npos;
+}
+
+StrRef StrRef::substr(size_t pos, size_t n) const
+{
+	if (pos > len)
+		pos = len;
+	if (n > len - pos)
+		n = len - pos;
+	return StrRef(ptr + pos, n);
+}
+
+StrRef StrRef::trim() const
+{
+	size_t start = 0, end = len;
+	while (start < end && isspace((unsigned char) ptr[start]))
+		start++;
+	while (end > start && isspace((unsigned char) ptr[end - 1]))
+		end--;
+	return StrRef(ptr + start, end - start);
+}
+
+int StrRef::toInt() const
+{
+	size_t i = 0;
+	bool negative = false;
+	int value = 0;
+
+	while (i < len && isspace((unsigned char) ptr[i]))
+		i++;
+	if (i < len && (ptr[i] == '-' || ptr[i] == '+'))
+		negative = ptr[i++] == '-';
+	for (; i < len && isdigit((unsigned char) ptr[i]); i++)
+		value = value * 10 + (ptr[i] - '0');
+
+	return negative ? -value : value;
+}
+
+ConfReader::ConfReader(const string &path)
+	: data(nullptr)
+	, size(0)
+	, pos(0)
+	, opened(false)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return;
+	}
+	opened = true;
+
+	if (st.st_size > 0) {
+		void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			data = (const char *) map;
+			size = st.st_size;
+		} else {
+			WARNING("Unable to map file %s\n", path.c_str());
+		}
+	}
+	close(fd);
+}
+
+ConfReader::~ConfReader()
+{
+	if (data)
+		munmap((void *) data, size);
+}
+
+bool ConfReader::next(StrRef &key, StrRef &value, bool *quoted)
+{
+	while (pos < size) {
+		const char *start = data + pos;
+		const char *eol = (const char *) memchr(start, '\n', size - pos);
+		size_t len = eol ? eol - start : size - pos;
+		pos += len + 1;
+
+		StrRef line = StrRef(start, len).trim();
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		size_t sep = line.find('=');
+		if (sep == StrRef::npos)
+			continue;
+
+		key = line.substr(0, sep).trim();
+		value = line.substr(sep + 1).trim();
+
+		if (quoted) {
+			*quoted = value.size() > 1 && value[0] == '"'
+						&& value[value.size() - 1] == '"';
+			if (*quoted)
+				value = value.substr(1, value.size() - 2);
+		}
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,92 @@
+#ifndef CONFREADER_H
+#define CONFREADER_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+/**
+ * A range of characters owned by someone else, usually the buffer of a
+ * ConfReader; a stand-in for C++17's std::string_view.
+ * It is only valid as long as its owner is alive.
+ */
+class StrRef {
+public:
+	static const size_t npos = (size_t) -1;
+
+	StrRef() : ptr(nullptr), len(0) {}
+	StrRef(const char *ptr, size_t len) : ptr(ptr), len(len) {}
+
+	const char *data() const { return ptr; }
+	size_t size() const { return len; }
+	bool empty() const { return len == 0; }
+	char operator[](size_t i) const { return ptr[i]; }
+
+	std::string str() const { return std::string(ptr, len); }
+
+	bool operator==(const char *other) const {
+		return !strncmp(ptr, other, len) && other[len] == '\0';
+	}
+	bool operator!=(const char *other) const { return !(*this == other); }
+	bool operator==(const StrRef &other) const {
+		return len == other.len && !memcmp(ptr, other.ptr, len);
+	}
+	bool operator!=(const StrRef &other) const { return !(*this == other); }
+
+	/** Returns the position of the first "c", or npos if there is none. */
+	size_t find(char c) const;
+	StrRef substr(size_t pos, size_t n = npos) const;
+	/** Returns this range without its leading and trailing whitespace. */
+	StrRef trim() const;
+	/** Parses a decimal integer, with the same leniency as atoi(). */
+	int toInt() const;
+
+private:
+	const char *ptr;
+	size_t len;
+};
+
+/** FNV-1a hash, so that StrRef can be used as an unordered_map key. */
+struct StrRefHash {
+	size_t operator()(const StrRef &ref) const {
+		size_t hash = 2166136261u;
+		for (size_t i = 0; i < ref.size(); i++) {
+			hash ^= (unsigned char) ref[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+};
+
+/**
+ * Reads "key=value" files: gmenu2x.conf, skin.conf, links, alias files,
+ * translations and input.conf.
+ *
+ * The whole file is mapped into memory, and the keys and values are
+ * returned as ranges of that mapping, so that no string is allocated
+ * unless the caller wants to keep one.
+ */
+class ConfReader {
+public:
+	ConfReader(const std::string &path);
+	~ConfReader();
+
+	/** Returns false if the file could not be opened. */
+	bool isOpen() { return opened; }
+
+	/**
+	 * Reads the next pair of the file. Blank lines, lines starting with
+	 * '#' and lines without a '=' are skipped. Keys and values are
+	 * trimmed. If "quoted" is not NULL, it is set to whether the value
+	 * was enclosed in double quotes, and the quotes are removed.
+	 * Returns false once the end of the file is reached.
+	 */
+	bool next(StrRef &key, StrRef &value, bool *quoted = nullptr);
+
+private:
+	const char *data;
+	size_t size, pos;
+	bool opened;
+};
+
+#endif
@@ -30,6 +30,10 @@ ContextMenu::ContextMenu(GMenu2X &gmenu2x, Menu &menu)
 
 	// Init menu options:
 
+	options.push_back(std::make_shared<MenuOption>(
+			tr["Search"],
+			std::bind(&GMenu2X::showSearch, &gmenu2x)));
+
 	options.push_back(std::make_shared<MenuOption>(
 			tr.translate("Add link in $1", menu.selSection().c_str(), NULL),
 			std::bind(&GMenu2X::addLink, &gmenu2x)));
@@ -25,6 +25,7 @@ public:
 	virtual void paint(Surface &s);
 	virtual bool handleButtonPress(InputManager::Button button);
 	virtual bool handleTouchscreen(Touchscreen &ts);
+	virtual const char *getName() { return "ContextMenu"; }
 
 private:
 	struct MenuOption;
@@ -1,10 +1,47 @@
 #include <string>
 
 #include "dialog.h"
+#include "debug.h"
 #include "gmenu2x.h"
 #include "font.h"
+#include "surface.h"
+#include "utilities.h"
 
-Dialog::Dialog(GMenu2X *gmenu2x) : gmenu2x(gmenu2x)
+#include <SDL.h>
+
+/* How long the letter overlay stays visible, in milliseconds. */
+static const unsigned int LETTER_OVERLAY_MS = 600;
+
+Dialog::Dialog(GMenu2X *gmenu2x)
+	: gmenu2x(gmenu2x)
+	, chromeVersion(0)
+	, overlayLetter(0)
+	, overlayTicks(0)
+{
+}
+
+Dialog::~Dialog()
+{
+}
+
+Surface *Dialog::getChrome()
+{
+	if (!chrome || chromeVersion != gmenu2x->bgVersion) {
+		// Shares the pixels of "bg" unless paintChrome() draws; "bg" is
+		// in the display format already.
+		chrome.reset(new Surface(gmenu2x->bg));
+		chromeVersion = gmenu2x->bgVersion;
+		paintChrome(chrome.get());
+	}
+	return chrome.get();
+}
+
+void Dialog::invalidateChrome()
+{
+	chrome.reset();
+}
+
+void Dialog::paintChrome(Surface *)
 {
 }
 
@@ -24,21 +61,51 @@ void Dialog::drawTitleIcon(const std::string &icon, bool skinRes, Surface *s)
 	if (i==NULL)
 		i = gmenu2x->sc.skinRes("icons/generic.png");
 
-	i->blit(s,4,(gmenu2x->skinConfInt["topBarHeight"]-32)/2);
+	i->blit(s,4,(gmenu2x->skinConf.topBarHeight-32)/2);
 }
 
 void Dialog::writeTitle(const std::string &title, Surface *s)
 {
 	if (s==NULL)
 		s = gmenu2x->s;
-	s->write(gmenu2x->font, title, 40, gmenu2x->skinConfInt["topBarHeight"] / 4, Font::HAlignLeft, Font::VAlignMiddle);
+	s->write(gmenu2x->font, title, 40, gmenu2x->skinConf.topBarHeight / 4, Font::HAlignLeft, Font::VAlignMiddle);
 }
 
 void Dialog::writeSubTitle(const std::string &subtitle, Surface *s)
 {
 	if (s==NULL)
 		s = gmenu2x->s;
-	s->write(gmenu2x->font, subtitle, 40, gmenu2x->skinConfInt["topBarHeight"] / 4 * 3, Font::HAlignLeft, Font::VAlignMiddle);
+	s->write(gmenu2x->font, subtitle, 40, gmenu2x->skinConf.topBarHeight / 4 * 3, Font::HAlignLeft, Font::VAlignMiddle);
+}
+
+
+
+static Uint32 hideLetterOverlay(Uint32, void *)
+{
+	/* Repaint once the overlay has expired; the timer does not repeat. */
+	inject_user_event();
+	return 0;
+}
+
+void Dialog::showLetterOverlay(char letter)
+{
+	overlayLetter = letter;
+	overlayTicks = SDL_GetTicks();
+	if (!SDL_AddTimer(LETTER_OVERLAY_MS, hideLetterOverlay, NULL))
+		ERROR("Could not initialize SDL timer: %s\n", SDL_GetError());
 }
 
+void Dialog::paintLetterOverlay()
+{
+	if (!overlayLetter || SDL_GetTicks() - overlayTicks >= LETTER_OVERLAY_MS)
+		return;
 
+	Surface *s = gmenu2x->s;
+	const int size = gmenu2x->font->getHeight() * 2;
+	const int x = (gmenu2x->resX - size) / 2, y = (gmenu2x->resY - size) / 2;
+	s->box(x, y, size, size, gmenu2x->skinConfColors[COLOR_MESSAGE_BOX_BG]);
+	s->rectangle(x, y, size, size,
+			gmenu2x->skinConfColors[COLOR_MESSAGE_BOX_BORDER]);
+	s->write(gmenu2x->font, std::string(1, overlayLetter),
+			x + size / 2, y + size / 2, Font::HAlignCenter, Font::VAlignMiddle);
+}
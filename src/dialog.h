@@ -1,6 +1,7 @@
 #ifndef __DIALOG_H__
 #define __DIALOG_H__
 
+#include <memory>
 #include <string>
 
 class GMenu2X;
@@ -10,13 +11,40 @@ class Dialog
 {
 public:
 	Dialog(GMenu2X *gmenu2x);
+	virtual ~Dialog();
 
 protected:
+	/**
+	 * Returns the background of the dialog: the wallpaper and bars, with
+	 * paintChrome() drawn over them. It is built on first use and kept
+	 * until invalidateChrome() is called or the skin changes, so painting
+	 * it costs a single blit. A dialog that draws nothing there shares the
+	 * pixels of the background instead of copying them.
+	 */
+	Surface *getChrome();
+	void invalidateChrome();
+	/** Draws the parts of the dialog that do not change between frames. */
+	virtual void paintChrome(Surface *s);
+
 	void drawTitleIcon(const std::string &icon, bool skinRes = false, Surface *s = NULL);
 	void writeTitle(const std::string &title, Surface *s = NULL);
 	void writeSubTitle(const std::string &subtitle, Surface *s = NULL);
 
+	/**
+	 * Shows "letter" over the list for a moment, after a jump to a letter
+	 * group; paintLetterOverlay() draws it as long as it is visible.
+	 */
+	void showLetterOverlay(char letter);
+	void paintLetterOverlay();
+
 	GMenu2X *gmenu2x;
+
+private:
+	std::unique_ptr<Surface> chrome;
+	unsigned int chromeVersion;
+
+	char overlayLetter;
+	unsigned int overlayTicks;
 };
 
 #endif
@@ -0,0 +1,164 @@
+#include "dircache.h"
+
+#include "collation.h"
+#include "debug.h"
+
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+using namespace std;
+
+/* Limits on what is kept; the least recently used listings go first. */
+static const size_t MAX_DIRECTORIES = 32;
+static const size_t MAX_NAMES = 100000;
+
+/* FAT, which is what most SD cards use, stores modification times with a
+ * two second resolution: a directory changed within that window after it
+ * was listed could keep the same mtime, so such listings are not trusted. */
+static const time_t MTIME_RESOLUTION = 2;
+
+DirCache &DirCache::getInstance()
+{
+	static DirCache instance;
+	return instance;
+}
+
+DirCache::DirCache() : totalNames(0)
+{
+}
+
+shared_ptr<const DirListing> DirCache::get(const string &path)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) == -1) {
+		ERROR("Unable to open directory: %s\n", path.c_str());
+		return nullptr;
+	}
+
+	shared_ptr<const DirListing> listing = find(path, st);
+	if (listing)
+		return listing;
+
+	time_t listedAt = time(NULL);
+	listing = read(path);
+	if (listing)
+		put(path, listing, st.st_mtim, listedAt);
+	return listing;
+}
+
+shared_ptr<const DirListing> DirCache::find(const string &path)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) == -1)
+		return nullptr;
+	return find(path, st);
+}
+
+shared_ptr<const DirListing> DirCache::find(const string &path,
+		const struct stat &st)
+{
+	auto it = entries.find(path);
+	if (it == entries.end())
+		return nullptr;
+
+	Entry &entry = it->second;
+	if (entry.mtime.tv_sec != st.st_mtim.tv_sec
+			|| entry.mtime.tv_nsec != st.st_mtim.tv_nsec
+			|| !isSettled(entry.mtime, entry.listedAt)) {
+		remove(it);
+		return nullptr;
+	}
+
+	lru.splice(lru.begin(), lru, entry.lru);
+	return entry.listing;
+}
+
+void DirCache::put(const string &path, shared_ptr<const DirListing> listing,
+		const struct timespec &mtime, time_t listedAt)
+{
+	auto it = entries.find(path);
+	if (it != entries.end())
+		remove(it);
+
+	lru.push_front(path);
+	Entry &entry = entries[path];
+	entry.listing = listing;
+	entry.mtime = mtime;
+	entry.listedAt = listedAt;
+	entry.lru = lru.begin();
+	totalNames += listing->directories.size() + listing->files.size();
+
+	evict();
+}
+
+void DirCache::remove(EntryIter it)
+{
+	totalNames -= it->second.listing->directories.size()
+				+ it->second.listing->files.size();
+	lru.erase(it->second.lru);
+	entries.erase(it);
+}
+
+void DirCache::evict()
+{
+	/* The most recently used listing is always kept, however big. */
+	while (lru.size() > 1
+			&& (lru.size() > MAX_DIRECTORIES || totalNames > MAX_NAMES))
+		remove(entries.find(lru.back()));
+}
+
+bool DirCache::isSettled(const struct timespec &mtime, time_t listedAt)
+{
+	return listedAt - mtime.tv_sec > MTIME_RESOLUTION;
+}
+
+shared_ptr<DirListing> DirCache::read(const string &path,
+		const EntryCallback &callback)
+{
+	DIR *dirp = opendir(path.c_str());
+	if (!dirp) {
+		ERROR("Unable to open directory: %s\n", path.c_str());
+		return nullptr;
+	}
+
+	shared_ptr<DirListing> listing(new DirListing);
+	struct stat st;
+	struct dirent *dptr;
+
+	while ((dptr = readdir(dirp))) {
+		const char *name = dptr->d_name;
+		if (name[0] == '.' && strcmp(name, ".."))
+			continue;
+
+		bool isDir;
+		if (dptr->d_type == DT_DIR) {
+			isDir = true;
+		} else if (dptr->d_type == DT_REG) {
+			isDir = false;
+		} else {
+			/* Unknown to the filesystem, or a symbolic link that
+			 * has to be followed: ask for the real type. */
+			if (fstatat(dirfd(dirp), name, &st, 0) == -1) {
+				ERROR("Stat failed on '%s%s' with error '%s'\n",
+							path.c_str(), name, strerror(errno));
+				continue;
+			}
+			isDir = S_ISDIR(st.st_mode);
+		}
+
+		(isDir ? listing->directories : listing->files).push_back(name);
+		if (callback && !callback(name, isDir)) {
+			closedir(dirp);
+			return nullptr;
+		}
+	}
+
+	closedir(dirp);
+	collationSort(listing->files);
+	collationSort(listing->directories);
+	return listing;
+}
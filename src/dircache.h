@@ -0,0 +1,95 @@
+#ifndef DIRCACHE_H
+#define DIRCACHE_H
+
+#include <ctime>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct stat;
+
+/**
+ * The entries of one directory, split by type and in collation order.
+ * Hidden entries (but not "..") are left out.
+ */
+struct DirListing {
+	std::vector<std::string> directories, files;
+};
+
+/**
+ * Process-wide cache of directory listings, so that opening the same
+ * folder again (or going up and back down) does not read it again.
+ *
+ * A cached listing is reused as long as the modification time of the
+ * directory has not changed, which costs a single stat() instead of a
+ * readdir() of the whole folder.
+ */
+class DirCache {
+public:
+	/** Called by read() for each entry; returning false stops reading. */
+	typedef std::function<bool(const char *name, bool isDir)> EntryCallback;
+
+	static DirCache &getInstance();
+
+	/**
+	 * Returns the listing of "path", which must end with a '/'.
+	 * Returns NULL if the directory cannot be read.
+	 */
+	std::shared_ptr<const DirListing> get(const std::string &path);
+
+	/**
+	 * Returns the cached listing of "path" if it is still valid,
+	 * NULL otherwise; the directory is never read.
+	 */
+	std::shared_ptr<const DirListing> find(const std::string &path);
+
+	/**
+	 * Adds a listing that was read with read(). "mtime" and "listedAt"
+	 * are the modification time of the directory and the current time,
+	 * both taken before reading it.
+	 */
+	void put(const std::string &path,
+			std::shared_ptr<const DirListing> listing,
+			const struct timespec &mtime, time_t listedAt);
+
+	/**
+	 * Reads "path" without using the cache. Unlike the rest of the class,
+	 * this can be called from any thread.
+	 * Returns NULL if the directory cannot be read or the callback
+	 * stopped the reading.
+	 */
+	static std::shared_ptr<DirListing> read(const std::string &path,
+			const EntryCallback &callback = EntryCallback());
+
+	/**
+	 * Returns true if a listing read at "listedAt" can be reused for as
+	 * long as the directory keeps the modification time "mtime" it had
+	 * then: a change made too soon after the mtime might not update it.
+	 */
+	static bool isSettled(const struct timespec &mtime, time_t listedAt);
+
+private:
+	struct Entry {
+		std::shared_ptr<const DirListing> listing;
+		struct timespec mtime;
+		time_t listedAt;
+		std::list<std::string>::iterator lru;
+	};
+	typedef std::unordered_map<std::string, Entry>::iterator EntryIter;
+
+	DirCache();
+
+	std::shared_ptr<const DirListing> find(const std::string &path,
+			const struct stat &st);
+	void remove(EntryIter it);
+	void evict();
+
+	std::unordered_map<std::string, Entry> entries;
+	std::list<std::string> lru; // most recently used first
+	size_t totalNames;
+};
+
+#endif
@@ -0,0 +1,129 @@
+#include "dirscanner.h"
+
+#include "debug.h"
+#include "utilities.h"
+
+#include <sys/stat.h>
+
+using namespace std;
+
+/* Number of entries read before they are handed over to the UI. */
+static const size_t BATCH_SIZE = 256;
+
+DirScanner::DirScanner(const string &path)
+	: path(path)
+	, finished(false)
+	, cancelled(false)
+	, notified(false)
+{
+	pthread_mutex_init(&mutex, NULL);
+	started = !pthread_create(&thread, NULL, threadMain, this);
+	if (!started) {
+		ERROR("Unable to create directory scanner thread\n");
+		finished = true;
+	}
+}
+
+DirScanner::~DirScanner()
+{
+	pthread_mutex_lock(&mutex);
+	cancelled = true;
+	pthread_mutex_unlock(&mutex);
+
+	if (started)
+		pthread_join(thread, NULL);
+	pthread_mutex_destroy(&mutex);
+}
+
+void *DirScanner::threadMain(void *p)
+{
+	static_cast<DirScanner *>(p)->run();
+	return NULL;
+}
+
+void DirScanner::run()
+{
+	struct stat st;
+	bool ok = stat(path.c_str(), &st) == 0;
+	time_t now = time(NULL);
+
+	shared_ptr<DirListing> listing;
+	if (ok) {
+		listing = DirCache::read(path, [this](const char *name, bool isDir) {
+			(isDir ? unpublished.directories : unpublished.files)
+						.push_back(name);
+			if (unpublished.directories.size() + unpublished.files.size()
+						< BATCH_SIZE)
+				return true;
+			return publish(false);
+		});
+	}
+
+	pthread_mutex_lock(&mutex);
+	if (listing && !cancelled) {
+		complete = listing;
+		mtime = st.st_mtim;
+		listedAt = now;
+	}
+	pthread_mutex_unlock(&mutex);
+	publish(true);
+}
+
+bool DirScanner::publish(bool last)
+{
+	pthread_mutex_lock(&mutex);
+	for (auto &dir : unpublished.directories)
+		pending.directories.push_back(std::move(dir));
+	for (auto &file : unpublished.files)
+		pending.files.push_back(std::move(file));
+	unpublished.directories.clear();
+	unpublished.files.clear();
+
+	if (last)
+		finished = true;
+
+	/* Only one wake-up at a time: the SDL event queue is small. */
+	bool notify = !notified && !cancelled;
+	notified = true;
+	bool keepGoing = !cancelled;
+	pthread_mutex_unlock(&mutex);
+
+	if (notify)
+		inject_user_event();
+	return keepGoing;
+}
+
+bool DirScanner::takeBatch(DirListing &batch)
+{
+	shared_ptr<const DirListing> listing;
+	struct timespec listingMtime;
+	time_t listingTime = 0;
+
+	pthread_mutex_lock(&mutex);
+	batch.directories.clear();
+	batch.files.clear();
+	swap(batch, pending);
+	notified = false;
+
+	if (finished && complete) {
+		listing = complete;
+		listingMtime = mtime;
+		listingTime = listedAt;
+		complete.reset();
+	}
+	pthread_mutex_unlock(&mutex);
+
+	if (listing)
+		DirCache::getInstance().put(path, listing, listingMtime, listingTime);
+
+	return !batch.directories.empty() || !batch.files.empty();
+}
+
+bool DirScanner::isDone()
+{
+	pthread_mutex_lock(&mutex);
+	bool done = finished && !complete && pending.directories.empty()
+				&& pending.files.empty();
+	pthread_mutex_unlock(&mutex);
+	return done;
+}
@@ -0,0 +1,53 @@
+#ifndef DIRSCANNER_H
+#define DIRSCANNER_H
+
+#include "dircache.h"
+
+#include <memory>
+#include <pthread.h>
+#include <string>
+
+/**
+ * Reads a directory on a background thread and hands its entries over in
+ * batches, so that a long listing can be shown while it is still being
+ * read. The UI is woken up with a repaint event whenever a new batch is
+ * ready.
+ *
+ * Once the whole directory has been read, the complete listing is added to
+ * the DirCache by the thread that takes the last batch.
+ */
+class DirScanner {
+public:
+	DirScanner(const std::string &path);
+	/** Stops reading, if it was not finished yet. */
+	~DirScanner();
+
+	/**
+	 * Moves the entries read since the last call into "batch", in no
+	 * particular order. Returns false if there were none.
+	 */
+	bool takeBatch(DirListing &batch);
+
+	/** Returns true once every entry has been taken. */
+	bool isDone();
+
+private:
+	static void *threadMain(void *p);
+	void run();
+	bool publish(bool last);
+
+	std::string path;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+
+	/* Owned by the worker thread. */
+	DirListing unpublished;
+	/* Guarded by "mutex". */
+	DirListing pending;
+	std::shared_ptr<const DirListing> complete;
+	struct timespec mtime;
+	time_t listedAt;
+	bool started, finished, cancelled, notified;
+};
+
+#endif
@@ -48,7 +48,7 @@ FileDialog::~FileDialog()
 
 bool FileDialog::exec() {
 	bool ret = BrowseDialog::exec();
-	if (ret && fl->isDirectory(selected)) {
+	if (ret && fl->isDirectory(getSelected())) {
 		// FileDialog must only pick regular files.
 		ret = false;
 	}
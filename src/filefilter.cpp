@@ -0,0 +1,45 @@
+#include "filefilter.h"
+
+#include "utilities.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+FileFilter::FileFilter(const string &filter)
+	: matchAll(filter == "*")
+{
+	if (matchAll)
+		return;
+
+	vector<string> vfilter;
+	split(vfilter, filter, ",");
+	for (auto &ext : vfilter) {
+		/* XXX: This won't accept UTF-8 codes.
+		 * Thanksfully file extensions shouldn't contain any. */
+		transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		extensions.insert(ext);
+	}
+}
+
+bool FileFilter::matches(const string &file) const
+{
+	if (matchAll)
+		return true;
+
+	string::size_type pos = file.find('.');
+	if (pos == string::npos)
+		return extensions.count("") != 0;
+
+	/* Try every suffix following a dot, so that multi-part extensions
+	 * such as "tar.gz" can be matched too. */
+	string ext;
+	for (; pos != string::npos; pos = file.find('.', pos + 1)) {
+		ext.assign(file, pos + 1, string::npos);
+		transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		if (extensions.count(ext))
+			return true;
+	}
+	return false;
+}
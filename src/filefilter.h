@@ -0,0 +1,25 @@
+#ifndef FILEFILTER_H
+#define FILEFILTER_H
+
+#include <string>
+#include <unordered_set>
+
+/**
+ * Matches file names against a link's selector filter: a comma-separated
+ * list of extensions, or "*" for every file. Extensions are compared without
+ * case, and an empty extension matches files that have none.
+ */
+class FileFilter {
+public:
+	FileFilter(const std::string &filter = "*");
+
+	bool matches(const std::string &file) const;
+	bool matchesAll() const { return matchAll; }
+
+private:
+	/* The filter, split on commas and lower-cased once. */
+	std::unordered_set<std::string> extensions;
+	bool matchAll;
+};
+
+#endif
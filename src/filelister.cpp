@@ -20,17 +20,12 @@
 
 #include "filelister.h"
 
-#include "debug.h"
+#include "collation.h"
+#include "dircache.h"
+#include "dirscanner.h"
 #include "utilities.h"
 
-//for browsing the filesystem
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <dirent.h>
-#include <errno.h>
-#include <iostream>
 #include <algorithm>
-#include <cstring>
 
 using namespace std;
 
@@ -38,6 +33,12 @@ FileLister::FileLister(const string &startPath, bool showDirectories,
 	bool showFiles) : showDirectories(showDirectories), showFiles(showFiles)
 {
 	setPath(startPath, false);
+	setFilter("");
+	indexLetters();
+}
+
+FileLister::~FileLister()
+{
 }
 
 const string &FileLister::getPath()
@@ -64,97 +65,195 @@ const string &FileLister::getFilter()
 void FileLister::setFilter(const string &filter)
 {
 	this->filter = filter;
+	fileFilter = FileFilter(filter);
 }
 
 void FileLister::browse(bool clean)
 {
+	scanner.reset();
 	if (clean) {
 		directories.clear();
 		files.clear();
+		dirKeys.clear();
+		fileKeys.clear();
+		indexLetters();
 	}
 
 	if (showDirectories || showFiles) {
-		DIR *dirp;
-		if ((dirp = opendir(path.c_str())) == NULL) {
-			ERROR("Unable to open directory: %s\n", path.c_str());
-			return;
-		}
+		shared_ptr<const DirListing> listing =
+					DirCache::getInstance().get(path);
+		if (listing)
+			add(*listing, true, false);
+	}
+}
 
-		string filepath, file;
-		struct stat st;
-		struct dirent *dptr;
+void FileLister::browseAsync()
+{
+	scanner.reset();
+	directories.clear();
+	files.clear();
+	dirKeys.clear();
+	fileKeys.clear();
+	indexLetters();
 
-		while ((dptr = readdir(dirp))) {
-			file = dptr->d_name;
+	if (showDirectories || showFiles) {
+		shared_ptr<const DirListing> listing =
+					DirCache::getInstance().find(path);
+		if (listing)
+			add(*listing, true, false);
+		else
+			scanner.reset(new DirScanner(path));
+	}
+}
 
-			if (file[0] == '.' && file != "..")
-				continue;
+bool FileLister::update()
+{
+	if (!scanner)
+		return false;
 
-			filepath = path + file;
-			int statRet = stat(filepath.c_str(), &st);
-			if (statRet == -1) {
-				ERROR("Stat failed on '%s' with error '%s'\n", filepath.c_str(), strerror(errno));
+	size_t oldSize = size();
+	DirListing batch;
+	if (scanner->takeBatch(batch))
+		add(batch, false, true);
+	if (scanner->isDone())
+		scanner.reset();
+
+	return size() != oldSize;
+}
+
+void FileLister::add(const DirListing &listing, bool sorted, bool distinct)
+{
+	/* Only merging into the entries of another listing requires checking
+	 * for duplicates; a single listing never has any. */
+	bool merge = !distinct && (!directories.empty() || !files.empty());
+	unordered_set<string> seenDirs, seenFiles;
+	if (merge) {
+		seenDirs.insert(directories.begin(), directories.end());
+		seenFiles.insert(files.begin(), files.end());
+	}
+
+	vector<string> newDirs, newFiles;
+	if (showDirectories) {
+		for (auto &dir : listing.directories) {
+			if (excludes.count(dir))
 				continue;
-			}
-			if (find(excludes.begin(), excludes.end(), file) != excludes.end())
+			if (!merge || seenDirs.insert(dir).second)
+				newDirs.push_back(dir);
+		}
+	}
+
+	if (showFiles) {
+		for (auto &file : listing.files) {
+			if (excludes.count(file) || !fileFilter.matches(file))
 				continue;
+			if (!merge || seenFiles.insert(file).second)
+				newFiles.push_back(file);
+		}
+	}
 
-			if (S_ISDIR(st.st_mode)) {
-				if (!showDirectories)
-					continue;
-
-				if (std::find(directories.begin(), directories.end(), file) != directories.end())
-				  continue;
-
-				directories.push_back(file);
-			} else {
-				if (!showFiles)
-					continue;
-
-				if (std::find(files.begin(), files.end(), file) != files.end())
-				  continue;
-
-				if (filter.compare("*") == 0) {
-					files.push_back(file);
-					continue;
-				}
-
-				vector<string> vfilter;
-				split(vfilter, filter, ",");
-				for (vector<string>::iterator it = vfilter.begin(); it != vfilter.end(); ++it) {
-					if (file.find('.') == string::npos) {
-						if (!it->empty())
-							continue;
-
-						files.push_back(file);
-						break;
-					}
-
-					if (it->length() < file.length()) {
-						if (file[file.length() - it->length() - 1] != '.')
-							continue;
-
-						string file_lowercase =
-									file.substr(file.length() - it->length());
-
-						/* XXX: This won't accept UTF-8 codes.
-						 * Thanksfully file extensions shouldn't contain any. */
-						transform(file_lowercase.begin(), file_lowercase.end(),
-									file_lowercase.begin(), ::tolower);
-
-						if (file_lowercase.compare(0, it->length(), *it) == 0) {
-							files.push_back(file);
-							break;
-						}
-					}
-				}
-			}
+	mergeSorted(directories, dirKeys, newDirs, sorted);
+	mergeSorted(files, fileKeys, newFiles, sorted);
+	indexLetters();
+}
+
+void FileLister::mergeSorted(vector<string> &vec, vector<string> &keys,
+		vector<string> &added, bool sorted)
+{
+	if (added.empty())
+		return;
+
+	/* A sorted listing can be taken as is: the keys are only computed
+	 * once something has to be merged into it. */
+	if (vec.empty() && sorted) {
+		vec.swap(added);
+		keys.clear();
+	} else {
+		collationMerge(vec, keys, added, sorted);
+	}
+}
+
+int FileLister::groupOf(const string &name)
+{
+	/* Must agree with the collation order, so that each group is a
+	 * contiguous range of the sorted entries. */
+	unsigned char c = name.empty() ? 0 : name[0];
+	if (c >= 'A' && c <= 'Z')
+		c += 'a' - 'A';
+	if (c < 'a')
+		return 0;
+	if (c <= 'z')
+		return c - 'a' + 1;
+	return NUM_GROUPS - 1;
+}
+
+void FileLister::indexLetters()
+{
+	const vector<string> *lists[] = { &directories, &files };
+	unsigned int *groups[] = { dirGroups, fileGroups };
+
+	for (int l = 0; l < 2; l++) {
+		const vector<string> &list = *lists[l];
+		for (int g = 0; g < NUM_GROUPS; g++) {
+			groups[l][g] = partition_point(list.begin(), list.end(),
+						[g](const string &name) { return groupOf(name) < g; })
+					- list.begin();
 		}
+		groups[l][NUM_GROUPS] = list.size();
+	}
+}
 
-		closedir(dirp);
-		sort(files.begin(), files.end(), case_less());
-		sort(directories.begin(), directories.end(), case_less());
+char FileLister::getLetter(unsigned int i)
+{
+	if (i >= size())
+		return '#';
+	int group = groupOf(isDirectory(i) ? directories[i]
+				: files[i - directories.size()]);
+	return group > 0 && group < NUM_GROUPS - 1 ? 'A' + group - 1 : '#';
+}
+
+unsigned int FileLister::nextLetter(unsigned int i)
+{
+	if (i >= size())
+		return 0;
+
+	bool inDirs = isDirectory(i);
+	unsigned int *groups = inDirs ? dirGroups : fileGroups;
+	unsigned int offset = inDirs ? 0 : directories.size();
+	int group = groupOf(inDirs ? directories[i] : files[i - offset]);
+
+	for (int g = group + 1; g < NUM_GROUPS; g++) {
+		if (groups[g] < groups[g + 1])
+			return offset + groups[g];
 	}
+
+	/* Last group: continue with the files, or wrap around. */
+	return inDirs && !files.empty() ? directories.size() : 0;
+}
+
+unsigned int FileLister::prevLetter(unsigned int i)
+{
+	if (i >= size())
+		return 0;
+
+	bool inDirs = isDirectory(i);
+	unsigned int *groups = inDirs ? dirGroups : fileGroups;
+	unsigned int offset = inDirs ? 0 : directories.size();
+	int group = groupOf(inDirs ? directories[i] : files[i - offset]);
+
+	if (i > offset + groups[group])
+		return offset + groups[group];
+	for (int g = group - 1; g >= 0; g--) {
+		if (groups[g] < groups[g + 1])
+			return offset + groups[g];
+	}
+
+	/* First group: continue with the last group of the directories, or
+	 * wrap around to the last group of the list. */
+	unsigned int last = !inDirs && !directories.empty()
+				? directories.size() - 1 : size() - 1;
+	if (last < directories.size())
+		return dirGroups[groupOf(directories[last])];
+	return directories.size() + fileGroups[groupOf(files[last - directories.size()])];
 }
 
 unsigned int FileLister::size()
@@ -172,12 +271,12 @@ unsigned int FileLister::fileCount()
 	return files.size();
 }
 
-string FileLister::operator[](uint x)
+const string &FileLister::operator[](uint x)
 {
 	return at(x);
 }
 
-string FileLister::at(uint x)
+const string &FileLister::at(uint x)
 {
 	if (x < directories.size())
 		return directories[x];
@@ -197,8 +296,10 @@ bool FileLister::isDirectory(unsigned int x)
 
 void FileLister::insertFile(const string &file) {
 	files.insert(files.begin(), file);
+	fileKeys.clear();
+	indexLetters();
 }
 
 void FileLister::addExclude(const string &exclude) {
-	excludes.push_back(exclude);
+	excludes.insert(exclude);
 }
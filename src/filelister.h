@@ -21,25 +21,73 @@
 #ifndef FILELISTER_H
 #define FILELISTER_H
 
+#include "filefilter.h"
+
+#include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
+class DirScanner;
+struct DirListing;
+
 class FileLister {
 private:
 	std::string path, filter;
 	bool showDirectories, showFiles;
 
-	std::vector<std::string> directories, files, excludes;
+	std::vector<std::string> directories, files;
+	/* Collation keys of the entries above, once some had to be merged. */
+	std::vector<std::string> dirKeys, fileKeys;
+	std::unordered_set<std::string> excludes;
+
+	FileFilter fileFilter;
+
+	std::unique_ptr<DirScanner> scanner;
+
+	/* Letter groups: 0 for the names sorting before "a", 1 to 26 for the
+	 * letters, 27 for the names sorting after "z". */
+	enum { NUM_GROUPS = 28 };
+	/* Position of the first entry of each group in "directories" and
+	 * "files"; an empty group starts where the next one does. The extra
+	 * slot holds the size of the list. */
+	unsigned int dirGroups[NUM_GROUPS + 1], fileGroups[NUM_GROUPS + 1];
+
+	static int groupOf(const std::string &name);
+	void indexLetters();
+
+	/**
+	 * Adds the entries of "listing" that pass the filter. "distinct" tells
+	 * that none of them can be among the current entries.
+	 */
+	void add(const DirListing &listing, bool sorted, bool distinct);
+	static void mergeSorted(std::vector<std::string> &vec,
+			std::vector<std::string> &keys, std::vector<std::string> &added,
+			bool sorted);
 
 public:
 	FileLister(const std::string &startPath = "/boot/local", bool showDirectories = true, bool showFiles = true);
+	~FileLister();
 	void browse(bool clean = true);
 
+	/**
+	 * Like browse(), but a directory that is not cached yet is read in the
+	 * background: its entries are then added by update() as they arrive.
+	 */
+	void browseAsync();
+	/**
+	 * Adds the entries read in the background since the last call, in
+	 * sorted order. Returns true if any entry was added.
+	 */
+	bool update();
+	/** Returns true while entries are still being read in the background. */
+	bool isLoading() { return scanner != nullptr; }
+
 	unsigned int size();
 	unsigned int dirCount();
 	unsigned int fileCount();
-	std::string operator[](unsigned int);
-	std::string at(unsigned int);
+	const std::string &operator[](unsigned int);
+	const std::string &at(unsigned int);
 	bool isFile(unsigned int);
 	bool isDirectory(unsigned int);
 
@@ -48,6 +96,22 @@ public:
 	const std::string &getFilter();
 	void setFilter(const std::string &filter);
 
+	/**
+	 * Returns the letter of the group of entry "i", as shown to the user:
+	 * 'A' to 'Z', or '#' for the other names.
+	 */
+	char getLetter(unsigned int i);
+	/**
+	 * Returns the position of the first entry of the next letter group
+	 * after the one of entry "i", wrapping around at the end.
+	 */
+	unsigned int nextLetter(unsigned int i);
+	/**
+	 * Returns the position of the first entry of the group of entry "i";
+	 * if "i" is that entry already, of the previous group.
+	 */
+	unsigned int prevLetter(unsigned int i);
+
 	const std::vector<std::string> &getDirectories() { return directories; }
 	const std::vector<std::string> &getFiles() { return files; }
 	void insertFile(const std::string &file);
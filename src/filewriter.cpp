@@ -0,0 +1,157 @@
+#include "filewriter.h"
+
+#include "debug.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static bool writeAll(int fd, const char *buf, size_t len)
+{
+	while (len) {
+		ssize_t ret = ::write(fd, buf, len);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		buf += ret;
+		len -= ret;
+	}
+	return true;
+}
+
+/* Makes the creation or renaming of a file in the directory durable. */
+static void syncDir(const string &path)
+{
+	string::size_type pos = path.rfind('/');
+	string dir = pos == string::npos ? "." : pos == 0 ? "/" : path.substr(0, pos);
+
+	int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+	if (fd < 0) {
+		WARNING("Unable to open directory '%s'\n", dir.c_str());
+		return;
+	}
+	if (fsync(fd) < 0)
+		WARNING("Unable to sync directory '%s'\n", dir.c_str());
+	close(fd);
+}
+
+/* Returns the template of the hidden temporary file used to write "path",
+ * for mkstemp(). */
+static string tempTemplate(const string &path)
+{
+	string::size_type pos = path.rfind('/');
+	if (pos == string::npos)
+		return "." + path + ".XXXXXX";
+	return path.substr(0, pos + 1) + "." + path.substr(pos + 1) + ".XXXXXX";
+}
+
+bool FileWriter::writeNow(const string &path, const string &contents)
+{
+	/* The name is unique: the writer thread and a direct call from the
+	 * UI thread may be writing the same file at once. */
+	string tmp = tempTemplate(path);
+
+	int fd = mkstemp(&tmp[0]);
+	if (fd < 0) {
+		ERROR("Unable to open '%s' for writing: %s\n",
+					tmp.c_str(), strerror(errno));
+		return false;
+	}
+	fchmod(fd, 0644);
+
+	bool ok = writeAll(fd, contents.data(), contents.size())
+				&& fdatasync(fd) == 0;
+	if (close(fd) < 0)
+		ok = false;
+
+	if (!ok || rename(tmp.c_str(), path.c_str()) < 0) {
+		ERROR("Unable to write '%s': %s\n", path.c_str(), strerror(errno));
+		unlink(tmp.c_str());
+		return false;
+	}
+	syncDir(path);
+
+	DEBUG("Wrote file: %s\n", path.c_str());
+	return true;
+}
+
+FileWriter::FileWriter()
+	: busy(false)
+	, quitting(false)
+{
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&queued, NULL);
+	pthread_cond_init(&done, NULL);
+	pthread_create(&thread, NULL, threadMain, (void *) this);
+}
+
+FileWriter::~FileWriter()
+{
+	pthread_mutex_lock(&mutex);
+	quitting = true;
+	pthread_cond_signal(&queued);
+	pthread_mutex_unlock(&mutex);
+
+	pthread_join(thread, NULL);
+	pthread_cond_destroy(&done);
+	pthread_cond_destroy(&queued);
+	pthread_mutex_destroy(&mutex);
+}
+
+void FileWriter::write(const string &path, const string &contents)
+{
+	pthread_mutex_lock(&mutex);
+	pending[path] = contents;
+	pthread_cond_signal(&queued);
+	pthread_mutex_unlock(&mutex);
+}
+
+void FileWriter::flush()
+{
+	pthread_mutex_lock(&mutex);
+	while (busy || !pending.empty())
+		pthread_cond_wait(&done, &mutex);
+	pthread_mutex_unlock(&mutex);
+}
+
+void *FileWriter::threadMain(void *p)
+{
+	static_cast<FileWriter *>(p)->run();
+	return NULL;
+}
+
+void FileWriter::run()
+{
+	pthread_mutex_lock(&mutex);
+	for (;;) {
+		while (pending.empty() && !quitting)
+			pthread_cond_wait(&queued, &mutex);
+		if (pending.empty())
+			break;
+
+		/* Take the file out of the queue before writing it, so that
+		 * a new write of the same file queued meanwhile is not lost. */
+		auto it = pending.begin();
+		string path = it->first, contents;
+		contents.swap(it->second);
+		pending.erase(it);
+		busy = true;
+
+		pthread_mutex_unlock(&mutex);
+		writeNow(path, contents);
+		pthread_mutex_lock(&mutex);
+
+		busy = false;
+		if (pending.empty())
+			pthread_cond_broadcast(&done);
+	}
+	pthread_mutex_unlock(&mutex);
+}
@@ -0,0 +1,54 @@
+#ifndef FILEWRITER_H
+#define FILEWRITER_H
+
+#include <map>
+#include <pthread.h>
+#include <string>
+
+/**
+ * Writes files from a background thread, so that the UI never has to wait
+ * for the storage.
+ *
+ * Each file is replaced atomically: the new contents are written to a
+ * hidden temporary file next to it and synced with fdatasync(), then the
+ * file is renamed over the old one and the directory is synced, so a crash
+ * leaves either the old or the new version. Only that file and directory
+ * are flushed to the storage, unlike with sync().
+ * Writing a file again before its previous write happened only keeps the
+ * latest contents.
+ */
+class FileWriter {
+public:
+	FileWriter();
+	~FileWriter();
+
+	/** Queues the given contents to be written to "path". */
+	void write(const std::string &path, const std::string &contents);
+
+	/**
+	 * Blocks until all the queued writes are done.
+	 * Call this before renaming or deleting a file that may have a pending
+	 * write, and before exiting or exec'ing another program.
+	 */
+	void flush();
+
+	/**
+	 * Writes a file right away, with the same atomicity as write().
+	 * Use this when the file has to be read back immediately.
+	 * Returns false if the file could not be written.
+	 */
+	static bool writeNow(const std::string &path, const std::string &contents);
+
+private:
+	static void *threadMain(void *p);
+	void run();
+
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t queued, done;
+
+	std::map<std::string, std::string> pending;
+	bool busy, quitting;
+};
+
+#endif
@@ -66,6 +66,8 @@ void Font::write(Surface *surface, const string &text,
 		return;
 	}
 
+	surface->detach();
+
 	if (text.find("\n", 0) == string::npos) {
 		writeLine(surface, text.c_str(), x, y, halign, valign);
 		return;
@@ -140,3 +142,67 @@ void Font::writeLine(Surface *surface, const char *text,
 	SDL_BlitSurface(s, NULL, surface->raw, &rect);
 	SDL_FreeSurface(s);
 }
+
+static inline Uint32 alphaAt(SDL_Surface *s, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= s->w || y >= s->h)
+		return 0;
+	Uint32 pixel = ((Uint32 *) ((Uint8 *) s->pixels + y * s->pitch))[x];
+	return (pixel & s->format->Amask) >> s->format->Ashift;
+}
+
+Surface *Font::render(const string &text)
+{
+	if (!font || text.empty()) {
+		return nullptr;
+	}
+
+	SDL_Color black = { 0, 0, 0, 0 }, white = { 0xff, 0xff, 0xff, 0 };
+	SDL_Surface *outline = TTF_RenderUTF8_Blended(font, text.c_str(), black);
+	SDL_Surface *fill = TTF_RenderUTF8_Blended(font, text.c_str(), white);
+	if (!outline || !fill) {
+		SDL_FreeSurface(outline);
+		SDL_FreeSurface(fill);
+		return nullptr;
+	}
+
+	const int w = fill->w + 2, h = fill->h + 2;
+	SDL_Surface *label = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_SRCALPHA,
+				w, h, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+	if (!label) {
+		SDL_FreeSurface(outline);
+		SDL_FreeSurface(fill);
+		return nullptr;
+	}
+
+	/* Composite what writeLine() blits: the black text shifted by one
+	 * pixel in each direction, then the white text on top. Blitting would
+	 * not do here, as SDL keeps the alpha channel of the destination. */
+	static const int offsets[4][2] = { { 1, 0 }, { 1, 2 }, { 0, 1 }, { 2, 1 } };
+	for (int y = 0; y < h; y++) {
+		Uint32 *row = (Uint32 *) ((Uint8 *) label->pixels + y * label->pitch);
+		for (int x = 0; x < w; x++) {
+			Uint32 clear = 255;
+			for (int i = 0; i < 4; i++) {
+				Uint32 a = alphaAt(outline,
+							x - offsets[i][0], y - offsets[i][1]);
+				clear = clear * (255 - a) / 255;
+			}
+			const Uint32 shadow = 255 - clear;
+			const Uint32 front = alphaAt(fill, x - 1, y - 1);
+			const Uint32 alpha = front + shadow * (255 - front) / 255;
+			const Uint32 value = alpha ? 255 * front / alpha : 0;
+			row[x] = (alpha << 24) | (value << 16) | (value << 8) | value;
+		}
+	}
+
+	SDL_FreeSurface(outline);
+	SDL_FreeSurface(fill);
+
+	SDL_Surface *converted = SDL_DisplayFormatAlpha(label);
+	if (converted) {
+		SDL_FreeSurface(label);
+		label = converted;
+	}
+	return new Surface(label, true);
+}
@@ -38,6 +38,14 @@ public:
 				const std::string &text, int x, int y,
 				HAlign halign = HAlignLeft, VAlign valign = VAlignTop);
 
+	/**
+	 * Renders a single line of text, outlined as write() draws it, into a
+	 * new surface that can be blitted as often as needed. The text starts
+	 * one pixel from the left and top edges of the surface, to leave room
+	 * for the outline. Returns NULL for an empty text.
+	 */
+	Surface *render(const std::string &text);
+
 private:
 	Font(TTF_Font *font);
 
@@ -0,0 +1,27 @@
+#include "framepacer.h"
+
+#include <SDL.h>
+
+FramePacer::FramePacer()
+	: nextFrame(0)
+{
+	setRate(30);
+}
+
+void FramePacer::setRate(unsigned int framesPerSecond)
+{
+	period = 1000000 / (framesPerSecond ? framesPerSecond : 1);
+}
+
+void FramePacer::waitForFrame()
+{
+	const uint64_t now = (uint64_t) SDL_GetTicks() * 1000;
+
+	// Behind by a frame or more, e.g. after waiting for input, or the
+	// tick counter wrapped around: start over.
+	if (now >= nextFrame + period || nextFrame > now + period)
+		nextFrame = now;
+	if (nextFrame > now)
+		SDL_Delay((nextFrame - now + 999) / 1000);
+	nextFrame += period;
+}
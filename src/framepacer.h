@@ -0,0 +1,28 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <stdint.h>
+
+/**
+ * Spaces out the frames of an animation to a target rate by sleeping until
+ * each frame is due, so that animating does not keep the CPU busy.
+ *
+ * Animations must be driven by the time that passed rather than by frame
+ * count: when painting takes longer than a frame, the missed deadlines are
+ * given up rather than caught up with.
+ */
+class FramePacer {
+public:
+	FramePacer();
+
+	/** Sets the number of frames per second to aim for. */
+	void setRate(unsigned int framesPerSecond);
+
+	/** Sleeps until the next frame is due. */
+	void waitForFrame();
+
+private:
+	uint64_t period, nextFrame; // microseconds
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include "gp2x.h"
 
 #include "background.h"
+#include "confreader.h"
 #include "cpu.h"
 #include "debug.h"
 #include "filedialog.h"
@@ -30,7 +31,9 @@
 #include "helppopup.h"
 #include "iconbutton.h"
 #include "inputdialog.h"
+#include "latencytrace.h"
 #include "linkapp.h"
+#include "mediaindex.h"
 #include "mediamonitor.h"
 #include "menu.h"
 #include "menusettingbool.h"
@@ -43,7 +46,9 @@
 #include "menusettingstring.h"
 #include "messagebox.h"
 #include "powersaver.h"
+#include "searchlayer.h"
 #include "settingsdialog.h"
+#include "stringpool.h"
 #include "textdialog.h"
 #include "wallpaperdialog.h"
 #include "utilities.h"
@@ -109,10 +114,10 @@ static const char *colorNames[NUM_COLORS] = {
 	"messageBoxSelection",
 };
 
-static enum color stringToColor(const string &name)
+static enum color stringToColor(const StrRef &name)
 {
 	for (unsigned int i = 0; i < NUM_COLORS; i++) {
-		if (strcmp(colorNames[i], name.c_str()) == 0) {
+		if (name == colorNames[i]) {
 			return (enum color)i;
 		}
 	}
@@ -124,6 +129,108 @@ static const char *colorToString(enum color c)
 	return colorNames[c];
 }
 
+Config::Config()
+	: tvoutEncoding("NTSC")
+	, saveSelection(0), section(0), link(0)
+	, outputLogs(0), backlightTimeout(15), buttonRepeatRate(10), frameRate(30)
+	, maxClock(0), menuClock(0)
+	, videoBpp(32), resolutionX(0), resolutionY(0)
+{
+}
+
+SkinConfig::SkinConfig()
+	: fontsize(0)
+	, topBarHeight(50), bottomBarHeight(20), linkWidth(80), linkHeight(50)
+{
+}
+
+/* Names of the known keys of the configuration files, and the fields they
+ * are stored in. The lists are terminated by an entry with a NULL name. */
+template<class Conf>
+struct ConfKeys {
+	struct Str { const char *name; string Conf::*field; };
+	struct Int { const char *name; int Conf::*field; };
+	static const Str strs[];
+	static const Int ints[];
+};
+
+template<> const ConfKeys<Config>::Str ConfKeys<Config>::strs[] = {
+	{ "skin", &Config::skin },
+	{ "wallpaper", &Config::wallpaper },
+	{ "lang", &Config::lang },
+	{ "tvoutEncoding", &Config::tvoutEncoding },
+	{ NULL, NULL },
+};
+
+template<> const ConfKeys<Config>::Int ConfKeys<Config>::ints[] = {
+	{ "saveSelection", &Config::saveSelection },
+	{ "section", &Config::section },
+	{ "link", &Config::link },
+	{ "outputLogs", &Config::outputLogs },
+	{ "backlightTimeout", &Config::backlightTimeout },
+	{ "buttonRepeatRate", &Config::buttonRepeatRate },
+	{ "frameRate", &Config::frameRate },
+	{ "maxClock", &Config::maxClock },
+	{ "menuClock", &Config::menuClock },
+	{ "videoBpp", &Config::videoBpp },
+	{ "resolutionX", &Config::resolutionX },
+	{ "resolutionY", &Config::resolutionY },
+	{ NULL, NULL },
+};
+
+template<> const ConfKeys<SkinConfig>::Str ConfKeys<SkinConfig>::strs[] = {
+	{ "font", &SkinConfig::font },
+	{ "wallpaper", &SkinConfig::wallpaper },
+	{ NULL, NULL },
+};
+
+template<> const ConfKeys<SkinConfig>::Int ConfKeys<SkinConfig>::ints[] = {
+	{ "fontsize", &SkinConfig::fontsize },
+	{ "topBarHeight", &SkinConfig::topBarHeight },
+	{ "bottomBarHeight", &SkinConfig::bottomBarHeight },
+	{ "linkWidth", &SkinConfig::linkWidth },
+	{ "linkHeight", &SkinConfig::linkHeight },
+	{ NULL, NULL },
+};
+
+template<class Conf>
+static void setConfStr(Conf &conf, const StrRef &name, const StrRef &value)
+{
+	for (auto key = ConfKeys<Conf>::strs; key->name; key++) {
+		if (name == key->name) {
+			(conf.*key->field).assign(value.data(), value.size());
+			return;
+		}
+	}
+	conf.extraStr[name.str()] = value.str();
+}
+
+template<class Conf>
+static void setConfInt(Conf &conf, const StrRef &name, int value)
+{
+	for (auto key = ConfKeys<Conf>::ints; key->name; key++) {
+		if (name == key->name) {
+			conf.*key->field = value;
+			return;
+		}
+	}
+	conf.extraInt[name.str()] = value;
+}
+
+template<class Conf>
+static void writeConf(ostream &out, const Conf &conf)
+{
+	for (auto key = ConfKeys<Conf>::strs; key->name; key++)
+		out << key->name << "=\"" << conf.*key->field << "\"" << endl;
+	for (auto &it : conf.extraStr)
+		out << it.first << "=\"" << it.second << "\"" << endl;
+
+	for (auto key = ConfKeys<Conf>::ints; key->name; key++)
+		out << key->name << "=" << conf.*key->field << endl;
+	for (auto &it : conf.extraInt)
+		out << it.first << "=" << it.second << endl;
+}
+
 static void quit_all(int err) {
     delete app;
     exit(err);
@@ -223,8 +330,9 @@ GMenu2X::GMenu2X()
 	}
 
 	bg = NULL;
+	bgVersion = 0;
 	font = NULL;
-	setSkin(confStr["skin"], !fileExists(confStr["wallpaper"]));
+	setSkin(conf.skin, !fileExists(conf.wallpaper));
 	layers.insert(layers.begin(), make_shared<Background>(*this));
 
 	/* We enable video at a later stage, so that the menu elements are
@@ -235,11 +343,11 @@ GMenu2X::GMenu2X()
 		quit();
 	}
 
-	s = Surface::openOutputSurface(resX, resY, confInt["videoBpp"]);
+	s = Surface::openOutputSurface(resX, resY, conf.videoBpp);
 
-	if (!fileExists(confStr["wallpaper"])) {
+	if (!fileExists(conf.wallpaper)) {
 		DEBUG("No wallpaper defined; we will take the default one.\n");
-		confStr["wallpaper"] = DEFAULT_WALLPAPER_PATH;
+		conf.wallpaper = DEFAULT_WALLPAPER_PATH;
 	}
 
 	initBG();
@@ -251,6 +359,13 @@ GMenu2X::GMenu2X()
 
 	initMenu();
 
+	vector<string> mediaRoots = menu->getSelectorDirs();
+	mediaRoots.push_back(CARD_ROOT);
+	MediaIndex::getInstance().start(mediaRoots);
+
+	// Measure the whole session, across the apps launched in between.
+	LatencyTrace::getInstance().load(getHome() + "/latency");
+
 #ifdef ENABLE_INOTIFY
 	monitor = new MediaMonitor(CARD_ROOT);
 #endif
@@ -265,12 +380,13 @@ GMenu2X::GMenu2X()
 		DEBUG("Loading system input.conf file: %s.\n", input_file.c_str());
 	}
 
-	input.init(&confInt["buttonRepeatRate"], input_file, menu.get());
+	input.init(&conf.buttonRepeatRate, input_file, menu.get());
+	pacer.setRate(conf.frameRate);
 
-	if (confInt["backlightTimeout"] > 0)
-        PowerSaver::getInstance()->setScreenTimeout( confInt["backlightTimeout"] );
+	if (conf.backlightTimeout > 0)
+        PowerSaver::getInstance()->setScreenTimeout( conf.backlightTimeout );
 #ifdef ENABLE_CPUFREQ
-	setClock(confInt["menuClock"]);
+	setClock(conf.menuClock);
 #endif
 }
 
@@ -286,6 +402,10 @@ GMenu2X::~GMenu2X() {
 }
 
 void GMenu2X::quit() {
+	// Saves the index, and leaves the disk to the app about to start.
+	MediaIndex::getInstance().stop();
+	LatencyTrace::getInstance().save(getHome() + "/latency");
+	fileWriter.flush();
 	fflush(NULL);
 	sc.clear();
 	delete s;
@@ -299,18 +419,22 @@ void GMenu2X::initBG() {
 
 	// Load wallpaper.
 	delete bg;
-	bg = Surface::loadImage(confStr["wallpaper"]);
+	bgVersion++;
+	bg = Surface::loadImage(conf.wallpaper);
 	if (!bg) {
 		bg = Surface::emptySurface(resX, resY);
 	}
 
 	drawTopBar(bg);
 	drawBottomBar(bg);
+	// Dialogs share this surface until they draw on it; converting it
+	// once here spares each of them a converted copy.
+	bg->convertToDisplayFormat();
 
 	Surface *bgmain = new Surface(bg);
 	sc.add(bgmain,"bgmain");
 
-	Surface *sd = Surface::loadImage("imgs/sd.png", confStr["skin"]);
+	Surface *sd = Surface::loadImage("imgs/sd.png", conf.skin);
 	if (sd) sd->blit(bgmain, 3, bottomBarIconY);
 
 	string df = getDiskFree(getHome().c_str());
@@ -319,7 +443,7 @@ void GMenu2X::initBG() {
 
 	cpuX = font->getTextWidth(df)+32;
 #ifdef ENABLE_CPUFREQ
-	Surface *cpu = Surface::loadImage("imgs/cpu.png", confStr["skin"]);
+	Surface *cpu = Surface::loadImage("imgs/cpu.png", conf.skin);
 	if (cpu) cpu->blit(bgmain, cpuX, bottomBarIconY);
 	cpuX += 19;
 	manualX = cpuX+font->getTextWidth("300MHz")+5;
@@ -332,27 +456,25 @@ void GMenu2X::initBG() {
 	if (usbnet) {
 		if (web) {
 			Surface *webserver = Surface::loadImage(
-				"imgs/webserver.png", confStr["skin"]);
+				"imgs/webserver.png", conf.skin);
 			if (webserver) webserver->blit(bgmain, serviceX, bottomBarIconY);
 			serviceX -= 19;
 			delete webserver;
 		}
 		if (samba) {
 			Surface *sambaS = Surface::loadImage(
-				"imgs/samba.png", confStr["skin"]);
+				"imgs/samba.png", conf.skin);
 			if (sambaS) sambaS->blit(bgmain, serviceX, bottomBarIconY);
 			serviceX -= 19;
 			delete sambaS;
 		}
 		if (inet) {
-			Surface *inetS = Surface::loadImage("imgs/inet.png", confStr["skin"]);
+			Surface *inetS = Surface::loadImage("imgs/inet.png", conf.skin);
 			if (inetS) inetS->blit(bgmain, serviceX, bottomBarIconY);
 			serviceX -= 19;
 			delete inetS;
 		}
 	}
-
-	bgmain->convertToDisplayFormat();
 }
 
 void GMenu2X::initFont() {
@@ -361,9 +483,9 @@ void GMenu2X::initFont() {
 		font = NULL;
 	}
 
-	string path = skinConfStr["font"];
+	string path = skinConf.font;
 	if (!path.empty()) {
-		unsigned int size = skinConfInt["fontsize"];
+		unsigned int size = skinConf.fontsize;
 		if (!size)
 			size = 12;
 		if (path.substr(0,5)=="skin:")
@@ -403,8 +525,10 @@ void GMenu2X::initMenu() {
 	menu->skinUpdated();
 	menu->orderLinks();
 
-	menu->setSectionIndex(confInt["section"]);
-	menu->setLinkIndex(confInt["link"]);
+	menu->setSectionIndex(conf.section);
+	menu->setLinkIndex(conf.link);
+
+	StringPool::getInstance().logStats();
 
 	layers.push_back(menu);
 }
@@ -454,155 +578,126 @@ void GMenu2X::viewLog() {
 }
 
 void GMenu2X::readConfig() {
+	conf = Config();
+#ifdef ENABLE_CPUFREQ
+	conf.maxClock = cpuFreqSafeMax;
+	conf.menuClock = cpuFreqMenuDefault;
+#endif
+
 	string conffile = GMENU2X_SYSTEM_DIR "/gmenu2x.conf";
 	readConfig(conffile);
 
 	conffile = getHome() + "/gmenu2x.conf";
 	readConfig(conffile);
-}
-
-void GMenu2X::readConfig(string conffile) {
-	if (fileExists(conffile)) {
-		ifstream inf(conffile.c_str(), ios_base::in);
-		if (inf.is_open()) {
-			string line;
-			while (getline(inf, line, '\n')) {
-				string::size_type pos = line.find("=");
-				string name = trim(line.substr(0,pos));
-				string value = trim(line.substr(pos+1,line.length()));
 
-				if (value.length()>1 && value.at(0)=='"' && value.at(value.length()-1)=='"')
-					confStr[name] = value.substr(1,value.length()-2);
-				else
-					confInt[name] = atoi(value.c_str());
-			}
-			inf.close();
-		}
-	}
-	if (!confStr["lang"].empty())
-		tr.setLang(confStr["lang"]);
+	if (!conf.lang.empty())
+		tr.setLang(conf.lang);
 
-	if (!confStr["wallpaper"].empty() && !fileExists(confStr["wallpaper"]))
-		confStr["wallpaper"] = "";
+	if (!conf.wallpaper.empty() && !fileExists(conf.wallpaper))
+		conf.wallpaper = "";
 
-	if (confStr["skin"].empty() || SurfaceCollection::getSkinPath(confStr["skin"]).empty())
-		confStr["skin"] = "Default";
+	if (conf.skin.empty() || SurfaceCollection::getSkinPath(conf.skin).empty())
+		conf.skin = "Default";
 
-	evalIntConf( confInt, "outputLogs", 0, 0,1 );
+	conf.outputLogs = constrain(conf.outputLogs, 0, 1);
 #ifdef ENABLE_CPUFREQ
-	evalIntConf( confInt, "maxClock",
-				 cpuFreqSafeMax, cpuFreqMin, cpuFreqMax );
-	evalIntConf( confInt, "menuClock",
-				 cpuFreqMenuDefault, cpuFreqMin, cpuFreqSafeMax );
+	conf.maxClock = constrain(conf.maxClock, cpuFreqMin, cpuFreqMax);
+	conf.menuClock = constrain(conf.menuClock, cpuFreqMin, cpuFreqSafeMax);
 #endif
-	evalIntConf( confInt, "backlightTimeout", 15, 0,120 );
-	evalIntConf( confInt, "buttonRepeatRate", 10, 0, 20 );
-	evalIntConf( confInt, "videoBpp", 32, 16, 32 );
+	conf.backlightTimeout = constrain(conf.backlightTimeout, 0, 120);
+	conf.buttonRepeatRate = constrain(conf.buttonRepeatRate, 0, 20);
+	conf.frameRate = constrain(conf.frameRate, 10, 60);
+	conf.videoBpp = constrain(conf.videoBpp, 16, 32);
+
+	if (conf.tvoutEncoding != "PAL") conf.tvoutEncoding = "NTSC";
+	resX = constrain( conf.resolutionX, 320,1920 );
+	resY = constrain( conf.resolutionY, 240,1200 );
+}
 
-	if (confStr["tvoutEncoding"] != "PAL") confStr["tvoutEncoding"] = "NTSC";
-	resX = constrain( confInt["resolutionX"], 320,1920 );
-	resY = constrain( confInt["resolutionY"], 240,1200 );
+void GMenu2X::readConfig(string conffile) {
+	ConfReader reader(conffile);
+	StrRef name, value;
+	bool quoted;
+
+	while (reader.next(name, value, &quoted)) {
+		if (quoted)
+			setConfStr(conf, name, value);
+		else
+			setConfInt(conf, name, value.toInt());
+	}
 }
 
 void GMenu2X::saveSelection() {
-	if (confInt["saveSelection"] && (
-			confInt["section"] != menu->selSectionIndex()
-			|| confInt["link"] != menu->selLinkIndex()
+	if (conf.saveSelection && (
+			conf.section != menu->selSectionIndex()
+			|| conf.link != menu->selLinkIndex()
 	)) {
+		conf.section = menu->selSectionIndex();
+		conf.link = menu->selLinkIndex();
 		writeConfig();
 	}
 }
 
 void GMenu2X::writeConfig() {
-	string conffile = getHome() + "/gmenu2x.conf";
-	ofstream inf(conffile.c_str());
-	if (inf.is_open()) {
-		ConfStrHash::iterator endS = confStr.end();
-		for(ConfStrHash::iterator curr = confStr.begin(); curr != endS; curr++)
-			inf << curr->first << "=\"" << curr->second << "\"" << endl;
-
-		ConfIntHash::iterator endI = confInt.end();
-		for(ConfIntHash::iterator curr = confInt.begin(); curr != endI; curr++)
-			inf << curr->first << "=" << curr->second << endl;
-
-		inf.close();
-	}
+	stringstream inf;
+	writeConf(inf, conf);
+	fileWriter.write(getHome() + "/gmenu2x.conf", inf.str());
 }
 
 void GMenu2X::writeSkinConfig() {
 	string conffile = getHome() + "/skins/";
 	if (!fileExists(conffile))
 	  mkdir(conffile.c_str(), 0770);
-	conffile = conffile + confStr["skin"];
+	conffile = conffile + conf.skin;
 	if (!fileExists(conffile))
 	  mkdir(conffile.c_str(), 0770);
 	conffile = conffile + "/skin.conf";
 
-	ofstream inf(conffile.c_str());
-	if (inf.is_open()) {
-		ConfStrHash::iterator endS = skinConfStr.end();
-		for(ConfStrHash::iterator curr = skinConfStr.begin(); curr != endS; curr++)
-			inf << curr->first << "=\"" << curr->second << "\"" << endl;
-
-		ConfIntHash::iterator endI = skinConfInt.end();
-		for(ConfIntHash::iterator curr = skinConfInt.begin(); curr != endI; curr++)
-			inf << curr->first << "=" << curr->second << endl;
-
-		int i;
-		for (i = 0; i < NUM_COLORS; ++i) {
-			inf << colorToString((enum color)i) << "=#";
-			inf.width(2); inf.fill('0');
-			inf << right << hex << skinConfColors[i].r;
-			inf.width(2); inf.fill('0');
-			inf << right << hex << skinConfColors[i].g;
-			inf.width(2); inf.fill('0');
-			inf << right << hex << skinConfColors[i].b;
-			inf.width(2); inf.fill('0');
-			inf << right << hex << skinConfColors[i].a << endl;
-		}
-
-		inf.close();
+	stringstream inf;
+	writeConf(inf, skinConf);
+
+	int i;
+	for (i = 0; i < NUM_COLORS; ++i) {
+		inf << colorToString((enum color)i) << "=#";
+		inf.width(2); inf.fill('0');
+		inf << right << hex << skinConfColors[i].r;
+		inf.width(2); inf.fill('0');
+		inf << right << hex << skinConfColors[i].g;
+		inf.width(2); inf.fill('0');
+		inf << right << hex << skinConfColors[i].b;
+		inf.width(2); inf.fill('0');
+		inf << right << hex << skinConfColors[i].a << endl;
 	}
+
+	fileWriter.write(conffile, inf.str());
 }
 
 void GMenu2X::readTmp() {
 	lastSelectorElement = -1;
-	if (fileExists("/tmp/gmenu2x.tmp")) {
-		ifstream inf("/tmp/gmenu2x.tmp", ios_base::in);
-		if (inf.is_open()) {
-			string line;
-			string section = "";
-			while (getline(inf, line, '\n')) {
-				string::size_type pos = line.find("=");
-				string name = trim(line.substr(0,pos));
-				string value = trim(line.substr(pos+1,line.length()));
-
-				if (name=="section")
-					menu->setSectionIndex(atoi(value.c_str()));
-				else if (name=="link")
-					menu->setLinkIndex(atoi(value.c_str()));
-				else if (name=="selectorelem")
-					lastSelectorElement = atoi(value.c_str());
-				else if (name=="selectordir")
-					lastSelectorDir = value;
-			}
-			inf.close();
-		}
+	ConfReader reader("/tmp/gmenu2x.tmp");
+	StrRef name, value;
+
+	while (reader.next(name, value)) {
+		if (name=="section")
+			menu->setSectionIndex(value.toInt());
+		else if (name=="link")
+			menu->setLinkIndex(value.toInt());
+		else if (name=="selectorelem")
+			lastSelectorElement = value.toInt();
+		else if (name=="selectordir")
+			lastSelectorDir = value.str();
 	}
 }
 
 void GMenu2X::writeTmp(int selelem, const string &selectordir) {
-	string conffile = "/tmp/gmenu2x.tmp";
-	ofstream inf(conffile.c_str());
-	if (inf.is_open()) {
-		inf << "section=" << menu->selSectionIndex() << endl;
-		inf << "link=" << menu->selLinkIndex() << endl;
-		if (selelem>-1)
-			inf << "selectorelem=" << selelem << endl;
-		if (!selectordir.empty())
-			inf << "selectordir=" << selectordir << endl;
-		inf.close();
-	}
+	stringstream inf;
+	inf << "section=" << menu->selSectionIndex() << endl;
+	inf << "link=" << menu->selLinkIndex() << endl;
+	if (selelem>-1)
+		inf << "selectorelem=" << selelem << endl;
+	if (!selectordir.empty())
+		inf << "selectordir=" << selectordir << endl;
+	fileWriter.write("/tmp/gmenu2x.tmp", inf.str());
 }
 
 void GMenu2X::main() {
@@ -653,16 +748,25 @@ void GMenu2X::main() {
 			}
 		}
 
-		// Handle other input events.
+		// Handle other input events. While animating, take a button
+		// press if there is one, else sleep until the next frame.
 		InputManager::Button button;
 		bool gotEvent;
-		const bool wait = !animating;
-		do {
-			gotEvent = input.getButton(&button, wait);
-		} while (wait && !gotEvent);
+		if (animating) {
+			gotEvent = input.getButton(&button, false);
+			if (!gotEvent)
+				pacer.waitForFrame();
+		} else {
+			do {
+				gotEvent = input.getButton(&button, true);
+			} while (!gotEvent);
+		}
 		if (gotEvent) {
 			for (auto it = layers.rbegin(); it != layers.rend(); ++it) {
-				if ((*it)->handleButtonPress(button)) {
+				// Handling the press can push a layer, moving the others.
+				shared_ptr<Layer> layer = *it;
+				if (layer->handleButtonPress(button)) {
+					LatencyTrace::getInstance().dispatched(layer->getName());
 					break;
 				}
 			}
@@ -678,8 +782,7 @@ void GMenu2X::main() {
 void GMenu2X::explorer() {
 	FileDialog fd(this, ts, tr["Select an application"], "sh,bin,py,elf,");
 	if (fd.exec()) {
-		if (confInt["saveSelection"] && (confInt["section"]!=menu->selSectionIndex() || confInt["link"]!=menu->selLinkIndex()))
-			writeConfig();
+		saveSelection();
 
 		string command = cmdclean(fd.getPath()+"/"+fd.getFile());
 		chdir(fd.getPath().c_str());
@@ -707,7 +810,7 @@ void GMenu2X::showHelpPopup() {
 
 void GMenu2X::showSettings() {
 #ifdef ENABLE_CPUFREQ
-	int curMenuClock = confInt["menuClock"];
+	int curMenuClock = conf.menuClock;
 #endif
 	bool showRootFolder = fileExists(CARD_ROOT);
 
@@ -729,35 +832,37 @@ void GMenu2X::showSettings() {
 
 	SettingsDialog sd(this, input, ts, tr["Settings"]);
 	sd.addSetting(new MenuSettingMultiString(this, ts, tr["Language"], tr["Set the language used by GMenu2X"], &lang, &fl_tr.getFiles()));
-	sd.addSetting(new MenuSettingBool(this, ts, tr["Save last selection"], tr["Save the last selected link and section on exit"], &confInt["saveSelection"]));
+	sd.addSetting(new MenuSettingBool(this, ts, tr["Save last selection"], tr["Save the last selected link and section on exit"], &conf.saveSelection));
 #ifdef ENABLE_CPUFREQ
-	sd.addSetting(new MenuSettingInt(this, ts, tr["Clock for GMenu2X"], tr["Set the cpu working frequency when running GMenu2X"], &confInt["menuClock"], cpuFreqMin, cpuFreqSafeMax, cpuFreqMultiple));
-	sd.addSetting(new MenuSettingInt(this, ts, tr["Maximum overclock"], tr["Set the maximum overclock for launching links"], &confInt["maxClock"], cpuFreqMin, cpuFreqMax, cpuFreqMultiple));
+	sd.addSetting(new MenuSettingInt(this, ts, tr["Clock for GMenu2X"], tr["Set the cpu working frequency when running GMenu2X"], &conf.menuClock, cpuFreqMin, cpuFreqSafeMax, cpuFreqMultiple));
+	sd.addSetting(new MenuSettingInt(this, ts, tr["Maximum overclock"], tr["Set the maximum overclock for launching links"], &conf.maxClock, cpuFreqMin, cpuFreqMax, cpuFreqMultiple));
 #endif
-	sd.addSetting(new MenuSettingBool(this, ts, tr["Output logs"], tr["Logs the output of the links. Use the Log Viewer to read them."], &confInt["outputLogs"]));
-	sd.addSetting(new MenuSettingInt(this, ts, tr["Screen Timeout"], tr["Set screen's backlight timeout in seconds"], &confInt["backlightTimeout"], 0, 120));
-//	sd.addSetting(new MenuSettingMultiString(this, ts, tr["Tv-Out encoding"], tr["Encoding of the tv-out signal"], &confStr["tvoutEncoding"], &encodings));
+	sd.addSetting(new MenuSettingBool(this, ts, tr["Output logs"], tr["Logs the output of the links. Use the Log Viewer to read them."], &conf.outputLogs));
+	sd.addSetting(new MenuSettingInt(this, ts, tr["Screen Timeout"], tr["Set screen's backlight timeout in seconds"], &conf.backlightTimeout, 0, 120));
+//	sd.addSetting(new MenuSettingMultiString(this, ts, tr["Tv-Out encoding"], tr["Encoding of the tv-out signal"], &conf.tvoutEncoding, &encodings));
 	sd.addSetting(new MenuSettingBool(this, ts, tr["Show root"], tr["Show root folder in the file selection dialogs"], &showRootFolder));
-	sd.addSetting(new MenuSettingInt(this, ts, tr["Button repeat rate"], tr["Set button repetitions per second"], &confInt["buttonRepeatRate"], 0, 20));
+	sd.addSetting(new MenuSettingInt(this, ts, tr["Button repeat rate"], tr["Set button repetitions per second"], &conf.buttonRepeatRate, 0, 20));
+	sd.addSetting(new MenuSettingInt(this, ts, tr["Animation frame rate"], tr["Set frames per second of the menu animations"], &conf.frameRate, 10, 60));
 
 	if (sd.exec() && sd.edited()) {
 #ifdef ENABLE_CPUFREQ
-		if (curMenuClock != confInt["menuClock"]) setClock(confInt["menuClock"]);
+		if (curMenuClock != conf.menuClock) setClock(conf.menuClock);
 #endif
 
-		if (confInt["backlightTimeout"] == 0) {
+		if (conf.backlightTimeout == 0) {
 			if (PowerSaver::isRunning())
 				delete PowerSaver::getInstance();
 		} else {
-			PowerSaver::getInstance()->setScreenTimeout( confInt["backlightTimeout"] );
+			PowerSaver::getInstance()->setScreenTimeout( conf.backlightTimeout );
 		}
 
 		input.repeatRateChanged();
+		pacer.setRate(conf.frameRate);
 
 		if (lang == "English") lang = "";
 		if (lang != tr.lang()) {
 			tr.setLang(lang);
-			confStr["lang"] = lang;
+			conf.lang = lang;
 		}
 		/*if (fileExists(CARD_ROOT) && !showRootFolder)
 			unlink(CARD_ROOT);
@@ -775,10 +880,10 @@ void GMenu2X::skinMenu() {
 	fl_sk.setPath(GMENU2X_SYSTEM_DIR "/skins", false);
 	fl_sk.browse(false);
 
-	string curSkin = confStr["skin"];
+	string curSkin = conf.skin;
 
 	SettingsDialog sd(this, input, ts, tr["Skin"]);
-	sd.addSetting(new MenuSettingMultiString(this, ts, tr["Skin"], tr["Set the skin used by GMenu2X"], &confStr["skin"], &fl_sk.getDirectories()));
+	sd.addSetting(new MenuSettingMultiString(this, ts, tr["Skin"], tr["Set the skin used by GMenu2X"], &conf.skin, &fl_sk.getDirectories()));
 	sd.addSetting(new MenuSettingRGBA(this, ts, tr["Top Bar"], tr["Color of the top bar"], &skinConfColors[COLOR_TOP_BAR_BG]));
 	sd.addSetting(new MenuSettingRGBA(this, ts, tr["Bottom Bar"], tr["Color of the bottom bar"], &skinConfColors[COLOR_BOTTOM_BAR_BG]));
 	sd.addSetting(new MenuSettingRGBA(this, ts, tr["Selection"], tr["Color of the selection and other interface details"], &skinConfColors[COLOR_SELECTION_BG]));
@@ -787,8 +892,8 @@ void GMenu2X::skinMenu() {
 	sd.addSetting(new MenuSettingRGBA(this, ts, tr["Message Box Selection"], tr["Color of the selection of the message box"], &skinConfColors[COLOR_MESSAGE_BOX_SELECTION]));
 
 	if (sd.exec() && sd.edited()) {
-		if (curSkin != confStr["skin"]) {
-			setSkin(confStr["skin"]);
+		if (curSkin != conf.skin) {
+			setSkin(conf.skin);
 			writeConfig();
 		}
 		writeSkinConfig();
@@ -797,11 +902,10 @@ void GMenu2X::skinMenu() {
 }
 
 void GMenu2X::setSkin(const string &skin, bool setWallpaper) {
-	confStr["skin"] = skin;
+	conf.skin = skin;
 
-	//Clear previous skin settings
-	skinConfStr.clear();
-	skinConfInt.clear();
+	//Reset previous skin settings
+	skinConf = SkinConfig();
 
 	DEBUG("GMenu2X: setting new skin %s.\n", skin.c_str());
 
@@ -823,42 +927,43 @@ void GMenu2X::setSkin(const string &skin, bool setWallpaper) {
 	if (!fileExists(skinconfname))
 	  skinconfname = GMENU2X_SYSTEM_DIR "/skins/" + skin + "/skin.conf";
 
-	if (fileExists(skinconfname)) {
-		ifstream skinconf(skinconfname.c_str(), ios_base::in);
-		if (skinconf.is_open()) {
-			string line;
-			while (getline(skinconf, line, '\n')) {
-				line = trim(line);
-				DEBUG("skinconf: '%s'\n", line.c_str());
-				string::size_type pos = line.find("=");
-				string name = trim(line.substr(0,pos));
-				string value = trim(line.substr(pos+1,line.length()));
-
-				if (value.length()>0) {
-					if (value.length()>1 && value.at(0)=='"' && value.at(value.length()-1)=='"')
-						skinConfStr[name] = value.substr(1,value.length()-2);
-					else if (value.at(0) == '#')
-						skinConfColors[stringToColor(name)] = strtorgba( value.substr(1,value.length()) );
-					else
-						skinConfInt[name] = atoi(value.c_str());
-				}
-			}
-			skinconf.close();
-
-			if (setWallpaper && !skinConfStr["wallpaper"].empty()) {
-				string fp = sc.getSkinFilePath("wallpapers/" + skinConfStr["wallpaper"]);
-				if (!fp.empty())
-					confStr["wallpaper"] = fp;
+	ConfReader skinconf(skinconfname);
+	if (skinconf.isOpen()) {
+		StrRef name, value;
+		bool quoted;
+		while (skinconf.next(name, value, &quoted)) {
+			DEBUG("skinconf: '%.*s' = '%.*s'\n",
+						(int) name.size(), name.data(),
+						(int) value.size(), value.data());
+
+			if (quoted) {
+				setConfStr(skinConf, name, value);
+			} else if (value.empty()) {
+				continue;
+			} else if (value[0] == '#') {
+				enum color c = stringToColor(name);
+				if (c == (enum color)-1)
+					WARNING("Unknown skin color: '%s'\n", name.str().c_str());
 				else
-					WARNING("Unable to find wallpaper defined on skin %s\n", skin.c_str());
+					skinConfColors[c] = strtorgba(value.substr(1).str());
+			} else {
+				setConfInt(skinConf, name, value.toInt());
 			}
 		}
+
+		if (setWallpaper && !skinConf.wallpaper.empty()) {
+			string fp = sc.getSkinFilePath("wallpapers/" + skinConf.wallpaper);
+			if (!fp.empty())
+				conf.wallpaper = fp;
+			else
+				WARNING("Unable to find wallpaper defined on skin %s\n", skin.c_str());
+		}
 	}
 
-	evalIntConf(skinConfInt, "topBarHeight", 50, 32, 120);
-	evalIntConf(skinConfInt, "bottomBarHeight", 20, 20, 120);
-	evalIntConf(skinConfInt, "linkHeight", 50, 32, 120);
-	evalIntConf(skinConfInt, "linkWidth", 80, 32, 120);
+	skinConf.topBarHeight = constrain(skinConf.topBarHeight, 32, 120);
+	skinConf.bottomBarHeight = constrain(skinConf.bottomBarHeight, 20, 120);
+	skinConf.linkHeight = constrain(skinConf.linkHeight, 32, 120);
+	skinConf.linkWidth = constrain(skinConf.linkWidth, 32, 120);
 
 	if (menu != NULL) menu->skinUpdated();
 
@@ -877,10 +982,14 @@ void GMenu2X::showContextMenu() {
 	layers.push_back(make_shared<ContextMenu>(*this, *menu));
 }
 
+void GMenu2X::showSearch() {
+	layers.push_back(make_shared<SearchLayer>(*this, *menu));
+}
+
 void GMenu2X::changeWallpaper() {
 	WallpaperDialog wp(this, ts);
-	if (wp.exec() && confStr["wallpaper"] != wp.wallpaper) {
-		confStr["wallpaper"] = wp.wallpaper;
+	if (wp.exec() && conf.wallpaper != wp.wallpaper) {
+		conf.wallpaper = wp.wallpaper;
 		initBG();
 		writeConfig();
 	}
@@ -933,7 +1042,7 @@ void GMenu2X::editLink() {
 		sd.addSetting(new MenuSettingBool(this, ts, tr["Selector Browser"], tr["Allow the selector to change directory"], &linkSelBrowser));
 	}
 #ifdef ENABLE_CPUFREQ
-	sd.addSetting(new MenuSettingInt(this, ts, tr["Clock frequency"], tr["Cpu clock frequency to set when launching this link"], &linkClock, cpuFreqMin, confInt["maxClock"], cpuFreqMultiple));
+	sd.addSetting(new MenuSettingInt(this, ts, tr["Clock frequency"], tr["Cpu clock frequency to set when launching this link"], &linkClock, cpuFreqMin, conf.maxClock, cpuFreqMultiple));
 #endif
 	if (!linkApp->isOpk()) {
 		sd.addSetting(new MenuSettingString(this, ts, tr["Selector Filter"], tr["Selector filter (Separate values with a comma)"], &linkSelFilter, diagTitle, diagIcon));
@@ -957,8 +1066,8 @@ void GMenu2X::editLink() {
 
 		//if section changed move file and update link->file
 		if (oldSection!=newSection) {
-			vector<string>::const_iterator newSectionIndex = find(menu->getSections().begin(),menu->getSections().end(),newSection);
-			if (newSectionIndex==menu->getSections().end()) return;
+			int newSectionIndex = menu->sectionNamed(newSection);
+			if (newSectionIndex < 0) return;
 			string newFileName = "sections/"+newSection+"/"+linkTitle;
 			uint x=2;
 			while (fileExists(newFileName)) {
@@ -967,12 +1076,13 @@ void GMenu2X::editLink() {
 				newFileName = "sections/"+newSection+"/"+linkTitle+id;
 				x++;
 			}
+			fileWriter.flush();
 			rename(linkApp->getFile().c_str(),newFileName.c_str());
 			linkApp->renameFile(newFileName);
 
-			INFO("New section index: %i.\n", newSectionIndex - menu->getSections().begin());
+			INFO("New section index: %i.\n", newSectionIndex);
 
-			menu->linkChangeSection(menu->selLinkIndex(), menu->selSectionIndex(), newSectionIndex - menu->getSections().begin());
+			menu->linkChangeSection(menu->selLinkIndex(), menu->selSectionIndex(), newSectionIndex);
 		}
 		linkApp->save();
 	}
@@ -992,8 +1102,7 @@ void GMenu2X::addSection() {
 	InputDialog id(this, input, ts, tr["Insert a name for the new section"]);
 	if (id.exec()) {
 		//only if a section with the same name does not exist
-		if (find(menu->getSections().begin(), menu->getSections().end(), id.getInput())
-				== menu->getSections().end()) {
+		if (menu->sectionNamed(id.getInput()) < 0) {
 			//section directory doesn't exists
 			if (menu->addSection(id.getInput()))
 				menu->setSectionIndex( menu->getSections().size()-1 ); //switch to the new section
@@ -1006,12 +1115,12 @@ void GMenu2X::renameSection() {
 	if (id.exec()) {
 		//only if a section with the same name does not exist & !samename
 		if (menu->selSection() != id.getInput()
-		 && find(menu->getSections().begin(),menu->getSections().end(), id.getInput())
-				== menu->getSections().end()) {
+		 && menu->sectionNamed(id.getInput()) < 0) {
 			//section directory doesn't exists
 			string newsectiondir = getHome() + "/sections/" + id.getInput();
 			string sectiondir = getHome() + "/sections/" + menu->selSection();
 
+			fileWriter.flush();
 			if (!rename(sectiondir.c_str(), newsectiondir.c_str())) {
 				string oldpng = menu->selSection() + ".png";
 				string newpng = id.getInput() + ".png";
@@ -1039,6 +1148,7 @@ void GMenu2X::deleteSection() {
 	mb.setButton(InputManager::CANCEL, tr["No"]);
 	if (mb.exec() == InputManager::ACCEPT) {
 
+		fileWriter.flush();
 		if (rmtree(getHome() + "/sections/" + menu->selSection()))
 			menu->deleteSelectedSection();
 	}
@@ -1051,7 +1161,7 @@ typedef struct {
 
 #ifdef ENABLE_CPUFREQ
 void GMenu2X::setClock(unsigned mhz) {
-	mhz = constrain(mhz, cpuFreqMin, confInt["maxClock"]);
+	mhz = constrain(mhz, cpuFreqMin, conf.maxClock);
 #if defined(PLATFORM_A320) || defined(PLATFORM_GCW0) || defined(PLATFORM_NANONOTE)
 	jz_cpuspeed(mhz);
 #endif
@@ -1139,7 +1249,7 @@ void GMenu2X::drawTopBar(Surface *s) {
 	if (bar) {
 		bar->blit(s, 0, 0);
 	} else {
-		const int h = skinConfInt["topBarHeight"];
+		const int h = skinConf.topBarHeight;
 		s->box(0, 0, resX, h, skinConfColors[COLOR_TOP_BAR_BG]);
 	}
 }
@@ -1149,7 +1259,7 @@ void GMenu2X::drawBottomBar(Surface *s) {
 	if (bar) {
 		bar->blit(s, 0, resY-bar->height());
 	} else {
-		const int h = skinConfInt["bottomBarHeight"];
+		const int h = skinConf.bottomBarHeight;
 		s->box(0, resY - h, resX, h, skinConfColors[COLOR_BOTTOM_BAR_BG]);
 	}
 }
@@ -22,6 +22,8 @@
 #define GMENU2X_H
 
 #include "contextmenu.h"
+#include "filewriter.h"
+#include "framepacer.h"
 #include "surfacecollection.h"
 #include "translator.h"
 #include "touchscreen.h"
@@ -71,6 +73,40 @@ enum color {
 typedef std::unordered_map<std::string, std::string, std::hash<std::string> > ConfStrHash;
 typedef std::unordered_map<std::string, int, std::hash<std::string> > ConfIntHash;
 
+/**
+ * Settings read from gmenu2x.conf.
+ * Keys the code knows about are resolved to fields once, when the file is
+ * parsed; any other key is kept in the "extra" hashes so that it is written
+ * back unchanged.
+ */
+struct Config {
+	Config();
+
+	std::string skin, wallpaper, lang, tvoutEncoding;
+	int saveSelection, section, link;
+	int outputLogs, backlightTimeout, buttonRepeatRate, frameRate;
+	int maxClock, menuClock;
+	int videoBpp, resolutionX, resolutionY;
+
+	ConfStrHash extraStr;
+	ConfIntHash extraInt;
+};
+
+/**
+ * Settings read from the skin.conf of the current skin.
+ * Colors are kept separately, in GMenu2X::skinConfColors.
+ */
+struct SkinConfig {
+	SkinConfig();
+
+	std::string font, wallpaper;
+	int fontsize;
+	int topBarHeight, bottomBarHeight, linkWidth, linkHeight;
+
+	ConfStrHash extraStr;
+	ConfIntHash extraInt;
+};
+
 class GMenu2X {
 private:
 	Touchscreen ts;
@@ -83,6 +119,7 @@ private:
 	std::string fileToLaunch;
 
 	std::vector<std::shared_ptr<Layer>> layers;
+	FramePacer pacer;
 
 	/*!
 	Retrieves the free disk space on the sd
@@ -143,31 +180,33 @@ public:
 	 * Gets the position and height of the area between the top and bottom bars.
 	 */
 	std::pair<unsigned int, unsigned int> getContentArea() {
-		const unsigned int top = skinConfInt["topBarHeight"];
-		const unsigned int bottom = skinConfInt["bottomBarHeight"];
+		const unsigned int top = skinConf.topBarHeight;
+		const unsigned int bottom = skinConf.bottomBarHeight;
 		return std::make_pair(top, resY - top - bottom);
 	}
 
 	InputManager input;
 
-	//Configuration hashes
-	ConfStrHash confStr, skinConfStr;
-	ConfIntHash confInt, skinConfInt;
+	//Configuration settings
+	Config conf;
+	SkinConfig skinConf;
 	RGBAColor skinConfColors[NUM_COLORS];
 
-	//Configuration settings
 	bool useSelectionPng;
 	void setSkin(const std::string &skin, bool setWallpaper = true);
 
 	SurfaceCollection sc;
 	Translator tr;
+	FileWriter fileWriter;
 	Surface *s, *bg;
+	unsigned int bgVersion; //!< Changes whenever "bg" is rebuilt
 	Font *font;
 
 	//Status functions
 	void main();
 	void showContextMenu();
 	void showHelpPopup();
+	void showSearch();
 	void showManual();
 	void showSettings();
 	void skinMenu();
@@ -6,9 +6,31 @@
 #include "gmenu2x.h"
 
 
+namespace {
+
+struct HelpLine {
+	const char *text;
+	int y;
+};
+
+const HelpLine helpLines[] = {
+	{ "CONTROLS", 60 },
+#if defined(PLATFORM_A320) || defined(PLATFORM_GCW0)
+	{ "A: Launch link / Confirm action", 80 },
+	{ "B: Show this help menu", 95 },
+	{ "L, R: Change section", 110 },
+	{ "SELECT: Show contextual menu", 155 },
+	{ "START: Show options menu", 170 },
+#endif
+};
+
+}
+
 HelpPopup::HelpPopup(GMenu2X &gmenu2x)
 	: gmenu2x(gmenu2x)
 {
+	for (auto &line : helpLines)
+		lines.push_back(gmenu2x.tr.intern(line.text));
 }
 
 void HelpPopup::paint(Surface &s) {
@@ -20,14 +42,8 @@ void HelpPopup::paint(Surface &s) {
 			gmenu2x.skinConfColors[COLOR_MESSAGE_BOX_BG]);
 	s.rectangle(12, 52, 296, helpBoxHeight,
 			gmenu2x.skinConfColors[COLOR_MESSAGE_BOX_BORDER]);
-	s.write(font, tr["CONTROLS"], 20, 60);
-#if defined(PLATFORM_A320) || defined(PLATFORM_GCW0)
-	s.write(font, tr["A: Launch link / Confirm action"], 20, 80);
-	s.write(font, tr["B: Show this help menu"], 20, 95);
-	s.write(font, tr["L, R: Change section"], 20, 110);
-	s.write(font, tr["SELECT: Show contextual menu"], 20, 155);
-	s.write(font, tr["START: Show options menu"], 20, 170);
-#endif
+	for (size_t i = 0; i < lines.size(); i++)
+		s.write(font, tr[lines[i]], 20, helpLines[i].y);
 }
 
 bool HelpPopup::handleButtonPress(InputManager::Button button) {
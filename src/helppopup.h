@@ -5,6 +5,9 @@
 #define HELPPOPUP_H
 
 #include "layer.h"
+#include "translator.h"
+
+#include <vector>
 
 class GMenu2X;
 
@@ -20,9 +23,11 @@ public:
 	virtual void paint(Surface &s);
 	virtual bool handleButtonPress(InputManager::Button button);
 	virtual bool handleTouchscreen(Touchscreen &ts);
+	virtual const char *getName() { return "HelpPopup"; }
 
 private:
 	GMenu2X &gmenu2x;
+	std::vector<Translator::Handle> lines;
 };
 
 #endif // HELPPOPUP_H
@@ -31,19 +31,29 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <vector>
 
 using namespace std;
 
+/* Number of entries above and below the cursor whose previews are loaded
+ * in advance. */
+static const int PREFETCH_DISTANCE = 2;
+
 ImageDialog::ImageDialog(
 		GMenu2X *gmenu2x, Touchscreen &ts, const string &text,
 		const string &filter, const string &file)
 	: FileDialog(gmenu2x, ts, text, filter, file, "Image Browser")
+	// Previews are kept small enough to leave the file names readable.
+	, previews([gmenu2x](const string &path) {
+		return Surface::loadThumbnail(
+				path, gmenu2x->resX / 2, gmenu2x->resY / 2, true);
+	})
 {
 
 	string path;
 
 	if (!file.empty()) {
-		path = strreplace(file, "skin:", gmenu2x->sc.getSkinPath(gmenu2x->confStr["skin"]));
+		path = strreplace(file, "skin:", gmenu2x->sc.getSkinPath(gmenu2x->conf.skin));
 		string::size_type pos = path.rfind("/");
 		if (pos != string::npos)
 			setPath(path.substr(0, pos));
@@ -55,8 +65,24 @@ ImageDialog::~ImageDialog() {
 }
 
 void ImageDialog::beforeFileList() {
-	if (fl->isFile(selected) && fileExists(getPath()+"/"+(*fl)[selected]))
-		previews[getPath()+"/"+(*fl)[selected]]->blitRight(gmenu2x->s, 310, 43);
+	/* The preview of the selected file comes first, then those of the
+	 * files around it, closest first. */
+	const int selected = getSelected();
+	vector<string> paths;
+	for (int distance = 0; distance <= PREFETCH_DISTANCE; distance++) {
+		for (int sign = 1; sign >= (distance ? -1 : 1); sign -= 2) {
+			int i = selected + sign * distance;
+			if (i >= 0 && fl->isFile(i))
+				paths.push_back(getPath() + "/" + (*fl)[i]);
+		}
+	}
+	previews.request(paths);
+
+	if (!paths.empty() && fl->isFile(selected)) {
+		Surface *preview = previews.get(paths.front());
+		if (preview)
+			preview->blitRight(gmenu2x->s, 310, 43);
+	}
 }
 
 void ImageDialog::onChangeDir() {
@@ -22,13 +22,13 @@
 #define IMAGEDIALOG_H
 
 #include "filedialog.h"
-#include "surfacecollection.h"
+#include "previewcache.h"
 
 #include <string>
 
 class ImageDialog : public FileDialog {
 protected:
-	SurfaceCollection previews;
+	PreviewCache previews;
 public:
 	ImageDialog(
 			GMenu2X *gmenu2x, Touchscreen &ts, const std::string &text,
@@ -10,6 +10,7 @@
 
 #include <SDL.h>
 #include <png.h>
+#include <algorithm>
 #include <cassert>
 
 #ifdef HAVE_LIBOPK
@@ -24,13 +25,18 @@ static void __readFromOpk(png_structp png_ptr, png_bytep ptr, png_size_t length)
 }
 #endif
 
-SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
+static SDL_Surface *readPNG(const std::string &path, bool loadAlpha,
+		unsigned int maxWidth, unsigned int maxHeight) {
 	// Declare these with function scope and initialize them to NULL,
 	// so we can use a single cleanup block at the end of the function.
 	SDL_Surface *surface = NULL;
 	FILE *fp = NULL;
 	png_structp png = NULL;
 	png_infop info = NULL;
+	// Volatile, since they are freed after a longjmp() from libpng.
+	png_bytep volatile rows = NULL;
+	Uint32 *volatile sums = NULL;
+	unsigned int factor = 1;
 #ifdef HAVE_LIBOPK
 	std::string::size_type pos;
 	struct OPK *opk = NULL;
@@ -116,6 +122,8 @@ SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
 	} else {
 		png_set_bgr(png); // BGRA in memory becomes ARGB in register
 	}
+	// - let libpng combine the passes of interlaced images
+	png_set_interlace_handling(png);
 
 	// Update the image info to the post-conversion state.
 	png_read_update_info(png, info);
@@ -134,9 +142,18 @@ SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
 		goto cleanup;
 	}
 
+	if (maxWidth && maxHeight) {
+		factor = std::max((width + maxWidth - 1) / maxWidth,
+					(height + maxHeight - 1) / maxHeight);
+		if (factor > std::min(width, height))
+			factor = std::min(width, height);
+		if (!factor)
+			factor = 1;
+	}
+
 	// Allocate [A]RGB surface to hold the image.
 	surface = SDL_CreateRGBSurface(
-		SDL_SWSURFACE | SDL_SRCALPHA, width, height, 32,
+		SDL_SWSURFACE | SDL_SRCALPHA, width / factor, height / factor, 32,
 		0x00FF0000, 0x0000FF00, 0x000000FF, loadAlpha ? 0xFF000000 : 0x00000000
 		);
 	if (!surface) {
@@ -146,7 +163,7 @@ SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
 
 	// Note: GCC 4.9 doesn't want to jump over 'rowPointers' with goto
 	//       if it is in the outer scope.
-	{
+	if (factor == 1) {
 		// Compute row pointers.
 		png_bytep rowPointers[height];
 		for (png_uint_32 y = 0; y < height; y++) {
@@ -156,6 +173,57 @@ SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
 
 		// Read the entire image in one go.
 		png_read_image(png, rowPointers);
+	} else {
+		// Average each factor x factor block of pixels, channel by
+		// channel, reading the rows one by one where libpng allows.
+		const png_uint_32 rowBytes = width * 4;
+		const bool interlaced =
+				png_get_interlace_type(png, info) != PNG_INTERLACE_NONE;
+		png_bytep buffer = static_cast<png_bytep>(
+				malloc(interlaced ? rowBytes * height : rowBytes));
+		Uint32 *acc = static_cast<Uint32 *>(calloc(surface->w * 4, sizeof(Uint32)));
+		rows = buffer;
+		sums = acc;
+		if (!buffer || !acc) {
+			SDL_FreeSurface(surface);
+			surface = NULL;
+			goto cleanup;
+		}
+
+		if (interlaced) {
+			png_bytep rowPointers[height];
+			for (png_uint_32 y = 0; y < height; y++)
+				rowPointers[y] = buffer + y * rowBytes;
+			png_read_image(png, rowPointers);
+		}
+
+		const int channels = surface->w * 4;
+		for (int y = 0; y < surface->h; y++) {
+			for (unsigned int i = 0; i < factor; i++) {
+				png_bytep row = buffer;
+				if (interlaced)
+					row += (y * factor + i) * rowBytes;
+				else
+					png_read_row(png, buffer, NULL);
+
+				for (int c = 0; c < channels; c += 4) {
+					png_bytep p = row + c * factor;
+					for (unsigned int j = 0; j < factor; j++, p += 4) {
+						acc[c] += p[0];
+						acc[c + 1] += p[1];
+						acc[c + 2] += p[2];
+						acc[c + 3] += p[3];
+					}
+				}
+			}
+
+			png_bytep out =
+				static_cast<png_bytep>(surface->pixels) + y * surface->pitch;
+			for (int c = 0; c < channels; c++) {
+				out[c] = acc[c] / (factor * factor);
+				acc[c] = 0;
+			}
+		}
 	}
 
 	// Read rest of file, and get additional chunks in the info struct.
@@ -166,6 +234,8 @@ cleanup:
 	// Clean up.
 	png_destroy_read_struct(&png, &info, NULL);
 	if (fp) fclose(fp);
+	free(rows);
+	free(sums);
 #ifdef HAVE_LIBOPK
 	if (buffer)
 		free(buffer);
@@ -175,3 +245,12 @@ cleanup:
 
 	return surface;
 }
+
+SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
+	return readPNG(path, loadAlpha, 0, 0);
+}
+
+SDL_Surface *loadPNGThumbnail(const std::string &path,
+		unsigned int maxWidth, unsigned int maxHeight, bool loadAlpha) {
+	return readPNG(path, loadAlpha, maxWidth, maxHeight);
+}
@@ -9,4 +9,12 @@ struct SDL_Surface;
   */
 SDL_Surface *loadPNG(const std::string &path, bool loadAlpha = true);
 
+/** Loads an image from a PNG file into a newly allocated 32bpp surface,
+  * shrunk by a whole factor until it fits in maxWidth x maxHeight. Unless
+  * the file is interlaced, only one row of the full-size image is kept in
+  * memory while decoding.
+  */
+SDL_Surface *loadPNGThumbnail(const std::string &path,
+		unsigned int maxWidth, unsigned int maxHeight, bool loadAlpha = false);
+
 #endif
@@ -24,6 +24,7 @@
 #include "delegate.h"
 #include "gmenu2x.h"
 #include "iconbutton.h"
+#include "latencytrace.h"
 #include "surface.h"
 #include "utilities.h"
 
@@ -119,6 +120,9 @@ InputDialog::InputDialog(GMenu2X *gmenu2x, InputManager &inputMgr_,
 			"skin:imgs/buttons/cancel.png", gmenu2x->tr["Change keys"]);
 	btnChangeKeys->setAction(BIND(&InputDialog::changeKeys));
 	buttonbox->add(btnChangeKeys);
+
+	cancelLabel = gmenu2x->tr.intern("Cancel");
+	okLabel = gmenu2x->tr.intern("OK");
 }
 
 void InputDialog::setKeyboard(int kb) {
@@ -143,7 +147,16 @@ void InputDialog::setKeyboard(int kb) {
 	kbRect.h = kbHeight;
 }
 
+void InputDialog::paintChrome(Surface *s) {
+	drawTitleIcon(icon, false, s);
+	writeTitle(title, s);
+	writeSubTitle(text, s);
+	buttonbox->paint(s, 5);
+}
+
 bool InputDialog::exec() {
+	LatencyTrace::Scope scope("InputDialog");
+
 	SDL_Rect box = {
 		0, 60, 0, static_cast<Uint16>(gmenu2x->font->getHeight() + 4)
 	};
@@ -151,17 +164,10 @@ bool InputDialog::exec() {
 	Uint32 caretTick = 0, curTick;
 	bool caretOn = true;
 
-	Surface bg(gmenu2x->bg);
-	drawTitleIcon(icon, false, &bg);
-	writeTitle(title, &bg);
-	writeSubTitle(text, &bg);
-	buttonbox->paint(&bg, 5);
-	bg.convertToDisplayFormat();
-
 	close = false;
 	ok = true;
 	while (!close) {
-		bg.blit(gmenu2x->s,0,0);
+		getChrome()->blit(gmenu2x->s,0,0);
 
 		box.w = gmenu2x->font->getTextWidth(input) + 18;
 		box.x = 160 - box.w / 2;
@@ -334,7 +340,7 @@ void InputDialog::drawVirtualKeyboard() {
 		selCol = 0;
 		selRow = kb->size();
 	}
-	gmenu2x->s->write(gmenu2x->font, gmenu2x->tr["Cancel"],
+	gmenu2x->s->write(gmenu2x->font, gmenu2x->tr[cancelLabel],
 			(int)(160 - kbLength * KEY_WIDTH / 4),
 			KB_TOP + kb->size() * KEY_HEIGHT + KEY_HEIGHT / 2,
 			Font::HAlignCenter, Font::VAlignMiddle);
@@ -345,7 +351,7 @@ void InputDialog::drawVirtualKeyboard() {
 		selCol = 1;
 		selRow = kb->size();
 	}
-	gmenu2x->s->write(gmenu2x->font, gmenu2x->tr["OK"],
+	gmenu2x->s->write(gmenu2x->font, gmenu2x->tr[okLabel],
 			(int)(160 + kbLength * KEY_WIDTH / 4),
 			KB_TOP + kb->size() * KEY_HEIGHT + KEY_HEIGHT / 2,
 			Font::HAlignCenter, Font::VAlignMiddle);
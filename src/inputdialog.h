@@ -22,6 +22,7 @@
 #define INPUTDIALOG_H
 
 #include "dialog.h"
+#include "translator.h"
 
 #include <SDL.h>
 #include <string>
@@ -46,6 +47,7 @@ private:
 	void confirm();
 	void changeKeys();
 
+	virtual void paintChrome(Surface *s);
 	void drawVirtualKeyboard();
 	void setKeyboard(int);
 
@@ -60,6 +62,7 @@ private:
 	int kbLength, kbWidth, kbHeight, kbLeft;
 	SDL_Rect kbRect;
 	ButtonBox *buttonbox;
+	Translator::Handle cancelLabel, okLabel;
 	std::string input;
 };
 
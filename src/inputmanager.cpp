@@ -18,14 +18,15 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include "confreader.h"
 #include "debug.h"
 #include "inputmanager.h"
+#include "latencytrace.h"
 #include "utilities.h"
 #include "powersaver.h"
 #include "menu.h"
 
 #include <iostream>
-#include <fstream>
 
 using namespace std;
 
@@ -79,18 +80,14 @@ InputManager::~InputManager()
 }
 
 void InputManager::readConfFile(const string &conffile) {
-	ifstream inf(conffile.c_str(), ios_base::in);
-	if (inf.fail()) {
+	ConfReader reader(conffile);
+	if (!reader.isOpen()) {
 		ERROR("InputManager: failed to open config file\n");
 		return;
 	}
 
-	string line;
-	while (getline(inf, line, '\n')) {
-		string::size_type pos = line.find("=");
-		string name = trim(line.substr(0,pos));
-		line = trim(line.substr(pos+1,line.length()));
-
+	StrRef name, value;
+	while (reader.next(name, value)) {
 		Button button;
 		if (name == "up")            button = UP;
 		else if (name == "down")     button = DOWN;
@@ -104,30 +101,28 @@ void InputManager::readConfFile(const string &conffile) {
 		else if (name == "settings") button = SETTINGS;
 		else {
 			WARNING("InputManager: Ignoring unknown button name \"%s\"\n",
-					name.c_str());
+					name.str().c_str());
 			continue;
 		}
 
-		pos = line.find(",");
-		string sourceStr = trim(line.substr(0,pos));
-		line = trim(line.substr(pos+1, line.length()));
+		size_t pos = value.find(',');
+		StrRef sourceStr = value.substr(0, pos).trim();
+		StrRef code = value.substr(pos == StrRef::npos ? pos : pos + 1).trim();
 
 		if (sourceStr == "keyboard") {
 			buttonMap[button].kb_mapped = true;
-			buttonMap[button].kb_code = atoi(line.c_str());
+			buttonMap[button].kb_code = code.toInt();
 #ifndef SDL_JOYSTICK_DISABLED
 		} else if (sourceStr == "joystick") {
 			buttonMap[button].js_mapped = true;
-			buttonMap[button].js_code = atoi(line.c_str());
+			buttonMap[button].js_code = code.toInt();
 #endif
 		} else {
 			WARNING("InputManager: Ignoring unknown button source \"%s\"\n",
-					sourceStr.c_str());
+					sourceStr.str().c_str());
 			continue;
 		}
 	}
-
-	inf.close();
 }
 
 InputManager::Button InputManager::waitForPressedButton() {
@@ -298,6 +293,7 @@ bool InputManager::getButton(Button *button, bool wait) {
 		PowerSaver::getInstance()->resetScreenTimer();
 	}
 
+	LatencyTrace::getInstance().received();
 	return true;
 }
 
@@ -0,0 +1,167 @@
+#include "latencytrace.h"
+
+#include "debug.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char *FILE_HEADER = "gmenu2x latency 1";
+
+/* Upper bounds of the buckets, in milliseconds; the last bucket holds the
+ * presses that took longer. 16 and 33 ms are one and two frames at 60 Hz. */
+static const unsigned int BUCKET_LIMITS[] = {
+	1, 2, 4, 8, 16, 33, 50, 100, 200, 500,
+};
+
+static const char *NO_SCREEN = "Other";
+
+LatencyTrace::Scope::Scope(const char *screen)
+{
+	getInstance().scopes.push_back(screen);
+}
+
+LatencyTrace::Scope::~Scope()
+{
+	getInstance().scopes.pop_back();
+}
+
+LatencyTrace::Histogram::Histogram()
+	: count(0)
+	, sum(0)
+	, max(0)
+{
+	for (auto &bucket : buckets)
+		bucket = 0;
+}
+
+void LatencyTrace::Histogram::add(uint64_t latency)
+{
+	count++;
+	sum += latency;
+	if (latency > max)
+		max = latency;
+
+	unsigned int i = 0;
+	while (i < NUM_BUCKETS - 1 && latency > BUCKET_LIMITS[i] * 1000ULL)
+		i++;
+	buckets[i]++;
+}
+
+LatencyTrace &LatencyTrace::getInstance()
+{
+	static LatencyTrace instance;
+	return instance;
+}
+
+LatencyTrace::LatencyTrace()
+{
+}
+
+uint64_t LatencyTrace::now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void LatencyTrace::received()
+{
+	Press press = { now(), scopes.empty() ? NULL : scopes.back() };
+	pending.push_back(press);
+}
+
+void LatencyTrace::dispatched(const char *screen)
+{
+	for (auto &press : pending) {
+		if (!press.screen)
+			press.screen = screen;
+	}
+}
+
+void LatencyTrace::discard()
+{
+	pending.clear();
+}
+
+void LatencyTrace::presented()
+{
+	if (pending.empty())
+		return;
+
+	const uint64_t time = now();
+	for (auto &press : pending) {
+		const char *screen = press.screen;
+		if (!screen)
+			screen = scopes.empty() ? NO_SCREEN : scopes.back();
+		histograms[screen].add(time - press.time);
+	}
+	pending.clear();
+}
+
+/* The file has one line per screen, with its name, the number of presses,
+ * their total and maximum latency in microseconds, and the number of presses
+ * in each bucket of BUCKET_LIMITS. */
+
+void LatencyTrace::load(const string &path)
+{
+	ifstream in(path.c_str());
+	string line;
+	if (!getline(in, line) || line != FILE_HEADER)
+		return;
+
+	while (getline(in, line)) {
+		istringstream fields(line);
+		string screen;
+		Histogram read;
+		fields >> screen >> read.count >> read.sum >> read.max;
+		for (auto &bucket : read.buckets)
+			fields >> bucket;
+		if (fields.fail() || !read.count) {
+			WARNING("Ignoring damaged latency trace '%s'\n", path.c_str());
+			continue;
+		}
+
+		Histogram &histogram = histograms[screen];
+		histogram.count += read.count;
+		histogram.sum += read.sum;
+		if (read.max > histogram.max)
+			histogram.max = read.max;
+		for (unsigned int i = 0; i < NUM_BUCKETS; i++)
+			histogram.buckets[i] += read.buckets[i];
+	}
+}
+
+void LatencyTrace::save(const string &path) const
+{
+	if (histograms.empty())
+		return;
+
+	// Written aside first, so that a failed write keeps the previous trace.
+	const string tmp = path + ".tmp";
+	ofstream out(tmp.c_str(), ios_base::out | ios_base::trunc);
+	out << FILE_HEADER << '\n';
+	for (auto &it : histograms) {
+		const Histogram &histogram = it.second;
+		out << it.first << ' ' << histogram.count << ' ' << histogram.sum
+			<< ' ' << histogram.max;
+		for (auto bucket : histogram.buckets)
+			out << ' ' << bucket;
+		out << '\n';
+
+		DEBUG("Latency of %s: %llu presses, %llu us on average, %llu us at most\n",
+				it.first.c_str(), (unsigned long long) histogram.count,
+				(unsigned long long) (histogram.sum / histogram.count),
+				(unsigned long long) histogram.max);
+	}
+	out.close();
+
+	if (out.fail() || rename(tmp.c_str(), path.c_str())) {
+		WARNING("Unable to save latency trace '%s'\n", path.c_str());
+		unlink(tmp.c_str());
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef LATENCYTRACE_H
+#define LATENCYTRACE_H
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Measures how long button presses take to show on screen: from the moment
+ * a press is taken from the SDL event queue to the end of the
+ * Surface::flip() that shows its effect.
+ *
+ * The latencies are kept in a histogram per screen. A press is charged to
+ * the modal dialog that received it; in the main loop, to the layer that
+ * handled it; failing that, to the dialog that painted the frame.
+ *
+ * The trace is not thread-safe: it must only be used from the main thread.
+ */
+class LatencyTrace {
+public:
+	/**
+	 * Charges the presses received during its lifetime to "screen",
+	 * which must be a string literal. Put one at the top of each modal
+	 * event loop.
+	 */
+	class Scope {
+	public:
+		Scope(const char *screen);
+		~Scope();
+	};
+
+	static LatencyTrace &getInstance();
+
+	/** Stamps a button press, as it is taken from the event queue. */
+	void received();
+	/** Charges the presses not charged yet to the layer "screen". */
+	void dispatched(const char *screen);
+	/** Forgets the presses that did not change the screen. */
+	void discard();
+	/** Records the pending presses; call when a frame is on screen. */
+	void presented();
+
+	/**
+	 * Adds the histograms saved to "path" to the current ones, so that
+	 * a session that launched apps in between is measured as a whole.
+	 */
+	void load(const std::string &path);
+	/** Saves the histograms to "path"; see latencytrace.cpp for the format. */
+	void save(const std::string &path) const;
+
+private:
+	struct Press {
+		uint64_t time; // microseconds
+		const char *screen;
+	};
+
+	static const unsigned int NUM_BUCKETS = 11;
+	struct Histogram {
+		Histogram();
+		void add(uint64_t latency);
+
+		uint64_t count, sum, max; // microseconds
+		uint64_t buckets[NUM_BUCKETS];
+	};
+
+	LatencyTrace();
+	static uint64_t now();
+
+	std::vector<const char *> scopes;
+	std::vector<Press> pending;
+	std::map<std::string, Histogram> histograms;
+};
+
+#endif
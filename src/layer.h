@@ -44,6 +44,12 @@ public:
 	 */
 	virtual bool handleTouchscreen(Touchscreen &ts) = 0;
 
+	/**
+	 * Returns the name that the latency of the button presses handled
+	 * by this layer is recorded under.
+	 */
+	virtual const char *getName() = 0;
+
 	Status getStatus() { return status; }
 
 protected:
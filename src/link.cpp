@@ -32,19 +32,20 @@
 using namespace std;
 
 
-Link::Link(GMenu2X *gmenu2x, function_t action)
+Link::Link(GMenu2X *gmenu2x, function_t action, Type type)
 	: gmenu2x(gmenu2x)
+	, type(type)
 	, ts(gmenu2x->getTouchscreen())
 	, action(action)
 	, lastTick(0)
 {
 //	ts = gmenu2x->getTouchscreen();
-	rect.w = gmenu2x->skinConfInt["linkWidth"];
-	rect.h = gmenu2x->skinConfInt["linkHeight"];
+	rect.x = rect.y = 0;
+	rect.w = gmenu2x->skinConf.linkWidth;
+	rect.h = gmenu2x->skinConf.linkHeight;
 	edited = false;
 	iconPath = gmenu2x->sc.getSkinFilePath("icons/generic.png");
-	iconX = 0;
-	padding = 0;
+	iconX = iconY = titleY = 0;
 
 	updateSurfaces();
 }
@@ -68,9 +69,9 @@ bool Link::handleTS() {
 
 void Link::paint() {
 	if (iconSurface) {
-		iconSurface->blit(gmenu2x->s, iconX, rect.y+padding, 32,32);
+		iconSurface->blit(gmenu2x->s, iconX, iconY, 32,32);
 	}
-	gmenu2x->s->write(gmenu2x->font, getTitle(), iconX+16, rect.y + gmenu2x->skinConfInt["linkHeight"]-padding, Font::HAlignCenter, Font::VAlignBottom);
+	gmenu2x->s->write(gmenu2x->font, title, iconX+16, titleY, Font::HAlignCenter, Font::VAlignBottom);
 }
 
 void Link::paintHover() {
@@ -117,8 +118,8 @@ const string &Link::getIcon() {
 }
 
 void Link::loadIcon() {
-	if (icon.compare(0, 5, "skin:") == 0) {
-		setIconPath(gmenu2x->sc.getSkinFilePath(icon.substr(5, string::npos)));
+	if (icon.str().compare(0, 5, "skin:") == 0) {
+		setIconPath(gmenu2x->sc.getSkinFilePath(icon.str().substr(5, string::npos)));
 	}
 }
 
@@ -166,8 +167,11 @@ void Link::setPosition(int x, int y) {
 }
 
 void Link::recalcCoordinates() {
+	const int linkHeight = gmenu2x->skinConf.linkHeight;
+	const int padding = (linkHeight - 32 - gmenu2x->font->getHeight()) / 3;
 	iconX = rect.x+(rect.w-32)/2;
-	padding = (gmenu2x->skinConfInt["linkHeight"] - 32 - gmenu2x->font->getHeight()) / 3;
+	iconY = rect.y + padding;
+	titleY = rect.y + linkHeight - padding;
 }
 
 void Link::run() {
@@ -22,6 +22,7 @@
 #define LINK_H
 
 #include "delegate.h"
+#include "stringpool.h"
 
 #include <SDL.h>
 #include <string>
@@ -38,9 +39,19 @@ Base class that represents a link on screen.
 */
 class Link {
 public:
-	Link(GMenu2X *gmenu2x, function_t action);
+	/**
+	 * The kind of entry a link represents, so that callers can tell
+	 * applications from built-in actions without using RTTI.
+	 */
+	enum class Type { ACTION, APP, OPK };
+
+	Link(GMenu2X *gmenu2x, function_t action, Type type = Type::ACTION);
 	virtual ~Link() {};
 
+	Type getType() { return type; }
+	/** Returns true if this link is a LinkApp (either a link file or an OPK). */
+	bool isApp() { return type != Type::ACTION; }
+
 	bool isPressed();
 	bool handleTS();
 
@@ -65,12 +76,23 @@ public:
 	void run();
 
 protected:
+	// The fields read on every frame by paint() and the touchscreen
+	// handling come first, so they share the first cache lines of the
+	// object; the editable strings below are only touched when the
+	// link is edited, launched or selected.
 	GMenu2X *gmenu2x;
-	bool edited;
-	std::string title, description, launchMsg, icon, iconPath;
-
 	Surface *iconSurface;
-	Surface *icon_hover;
+	Type type;
+
+private:
+	SDL_Rect rect;
+	int iconX, iconY, titleY;
+
+protected:
+	PooledString title;
+
+	bool edited;
+	PooledString description, launchMsg, icon, iconPath;
 
 	virtual const std::string &searchIcon();
 	void setIconPath(const std::string &icon);
@@ -81,9 +103,6 @@ private:
 
 	Touchscreen &ts;
 	function_t action;
-
-	SDL_Rect rect;
-	uint iconX, padding;
 	int lastTick;
 };
 
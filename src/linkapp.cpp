@@ -20,9 +20,11 @@
 
 #include "linkapp.h"
 
+#include "confreader.h"
 #include "debug.h"
 #include "delegate.h"
 #include "gmenu2x.h"
+#include "latencytrace.h"
 #include "menu.h"
 #include "selector.h"
 #include "surface.h"
@@ -64,7 +66,7 @@ LinkApp::LinkApp(GMenu2X *gmenu2x_, const char* linkfile,
 #else
 LinkApp::LinkApp(GMenu2X *gmenu2x_, const char* linkfile)
 #endif
-	: Link(gmenu2x_, BIND(&LinkApp::start))
+	: Link(gmenu2x_, BIND(&LinkApp::start), Type::APP)
 {
 	manual = "";
 	file = linkfile;
@@ -82,22 +84,27 @@ LinkApp::LinkApp(GMenu2X *gmenu2x_, const char* linkfile)
 #endif
 
 #ifdef HAVE_LIBOPK
-	isOPK = !!opk;
+	if (opk) {
+		type = Type::OPK;
 
-	if (isOPK) {
 		string::size_type pos;
 		const char *key, *val;
 		size_t lkey, lval;
 		int ret;
 
-		metadata.assign(metadata_);
+		metadata = metadata_;
 		opkFile = file;
-		pos = file.rfind('/');
-		opkMount = file.substr(pos+1);
-		pos = opkMount.rfind('.');
-		opkMount = opkMount.substr(0, pos);
 
-		file = gmenu2x->getHome() + "/sections/";
+		string mount = file.str();
+		pos = mount.rfind('/');
+		mount = mount.substr(pos+1);
+		pos = mount.rfind('.');
+		mount = mount.substr(0, pos);
+
+		string linkPath = gmenu2x->getHome() + "/sections/";
+		const string &lng = gmenu2x->tr["Lng"];
+		const string nameKey = "Name[" + lng + "]";
+		const string commentKey = "Comment[" + lng + "]";
 
 		while ((ret = opk_read_pair(opk, &key, &lkey, &val, &lval))) {
 			if (ret < 0) {
@@ -109,21 +116,20 @@ LinkApp::LinkApp(GMenu2X *gmenu2x_, const char* linkfile)
 			sprintf(buf, "%.*s", lval, val);
 
 			if (!strncmp(key, "Categories", lkey)) {
-				category = buf;
+				string cat = buf;
 
-				pos = category.find(';');
-				if (pos != category.npos)
-					category = category.substr(0, pos);
-				file += category + '/' + opkMount;
+				pos = cat.find(';');
+				if (pos != cat.npos)
+					cat = cat.substr(0, pos);
+				category = cat;
+				linkPath += cat + '/' + mount;
 
 			} else if ((!strncmp(key, "Name", lkey) && title.empty())
-						|| !strncmp(key, ("Name[" + gmenu2x->tr["Lng"] +
-								"]").c_str(), lkey)) {
+						|| !strncmp(key, nameKey.c_str(), lkey)) {
 				title = buf;
 
 			} else if ((!strncmp(key, "Comment", lkey) && description.empty())
-						|| !strncmp(key, ("Comment[" +
-								gmenu2x->tr["Lng"] + "]").c_str(), lkey)) {
+						|| !strncmp(key, commentKey.c_str(), lkey)) {
 				description = buf;
 
 #if defined(PLATFORM_A320) || defined(PLATFORM_GCW0)
@@ -160,7 +166,7 @@ LinkApp::LinkApp(GMenu2X *gmenu2x_, const char* linkfile)
 #ifdef HAVE_LIBXDGMIME
 			if (!strncmp(key, "MimeType", lkey)) {
 				string mimetypes = buf;
-				selectorfilter = "";
+				string filter;
 
 				while ((pos = mimetypes.find(';')) != mimetypes.npos) {
 					int nb = 16;
@@ -172,84 +178,77 @@ LinkApp::LinkApp(GMenu2X *gmenu2x_, const char* linkfile)
 								mimetype.c_str(), extensions, nb);
 
 					while (nb--) {
-						selectorfilter += (string) extensions[nb] + ',';
+						filter += (string) extensions[nb] + ',';
 						free(extensions[nb]);
 					}
 				}
 
 				/* Remove last comma */
-				if (!selectorfilter.empty()) {
-					selectorfilter.erase(selectorfilter.end());
-					DEBUG("Compatible extensions: %s\n", selectorfilter.c_str());
+				if (!filter.empty()) {
+					filter.erase(filter.size() - 1);
+					DEBUG("Compatible extensions: %s\n", filter.c_str());
 				}
+				selectorfilter = filter;
 
 				continue;
 			}
 #endif /* HAVE_LIBXDGMIME */
 		}
 
-		opkMount = (string) "/mnt/" + opkMount + '/';
+		file = linkPath;
+		opkMount = "/mnt/" + mount + '/';
 		edited = true;
 	}
 #endif /* HAVE_LIBOPK */
 
-	string line;
-	ifstream infile (file.c_str(), ios_base::in);
-	while (getline(infile, line, '\n')) {
-		line = trim(line);
-		if (line.empty()) continue;
-		if (line[0]=='#') continue;
-
-		string::size_type position = line.find("=");
-		string name = trim(line.substr(0,position));
-		string value = trim(line.substr(position+1));
-
+	ConfReader reader(file);
+	StrRef name, value;
+	while (reader.next(name, value)) {
 		if (name == "clock") {
-			setClock( atoi(value.c_str()) );
+			setClock( value.toInt() );
 		} else if (name == "selectordir") {
-			setSelectorDir( value );
+			setSelectorDir( value.str() );
 		} else if (name == "selectorbrowser") {
 			if (value=="false") selectorbrowser = false;
 		} else if (name == "selectoraliases") {
-			setAliasFile( value );
+			setAliasFile( value.str() );
 		} else if (!isOpk()) {
 			if (name == "title") {
-				title = value;
+				title = value.str();
 			} else if (name == "description") {
-				description = value;
+				description = value.str();
 			} else if (name == "launchmsg") {
-				launchMsg = value;
+				launchMsg = value.str();
 			} else if (name == "icon") {
-				setIcon(value);
+				setIcon(value.str());
 			} else if (name == "exec") {
-				exec = value;
+				exec = value.str();
 			} else if (name == "params") {
-				params = value;
+				params = value.str();
 			} else if (name == "manual") {
-				manual = value;
+				manual = value.str();
 #if defined(PLATFORM_A320) || defined(PLATFORM_GCW0)
 			} else if (name == "consoleapp") {
 				if (value == "true") consoleApp = true;
 #endif
 			} else if (name == "selectorfilter") {
-				setSelectorFilter( value );
+				setSelectorFilter( value.str() );
 			} else if (name == "editable") {
 				if (value == "false")
 					editable = false;
 			} else
-				WARNING("Unrecognized option: '%s'\n", name.c_str());
+				WARNING("Unrecognized option: '%s'\n", name.str().c_str());
 		} else
-			WARNING("Unrecognized option: '%s'\n", name.c_str());
+			WARNING("Unrecognized option: '%s'\n", name.str().c_str());
 	}
-	infile.close();
 
 	if (iconPath.empty()) searchIcon();
 }
 
 void LinkApp::loadIcon() {
-	if (icon.compare(0, 5, "skin:") == 0) {
+	if (icon.str().compare(0, 5, "skin:") == 0) {
 		string linkIcon = gmenu2x->sc.getSkinFilePath(
-				icon.substr(5, string::npos));
+				icon.str().substr(5, string::npos));
 		if (!fileExists(linkIcon))
 			searchIcon();
 		else
@@ -265,8 +264,8 @@ const string &LinkApp::searchIcon() {
 		return iconPath;
 
 	string execicon = exec;
-	string::size_type pos = exec.rfind(".");
-	if (pos != string::npos) execicon = exec.substr(0,pos);
+	string::size_type pos = execicon.rfind(".");
+	if (pos != string::npos) execicon = execicon.substr(0,pos);
 	execicon += ".png";
 	string exectitle = execicon;
 	pos = execicon.rfind("/");
@@ -295,9 +294,8 @@ const string &LinkApp::clockStr(int maxClock) {
 void LinkApp::setClock(int mhz) {
 	iclock = mhz;
 	stringstream ss;
-	sclock = "";
 	ss << iclock << "MHz";
-	ss >> sclock;
+	sclock = ss.str();
 
 	edited = true;
 }
@@ -312,31 +310,28 @@ bool LinkApp::save() {
 
 	DEBUG("Saving file: %s\n", file.c_str());
 
-	ofstream f(file.c_str());
-	if (f.is_open()) {
-		if (!isOpk()) {
-			if (!title.empty()       ) f << "title="           << title           << endl;
-			if (!description.empty() ) f << "description="     << description     << endl;
-			if (!launchMsg.empty()   ) f << "launchmsg="       << launchMsg       << endl;
-			if (!icon.empty()        ) f << "icon="            << icon            << endl;
-			if (!exec.empty()        ) f << "exec="            << exec            << endl;
-			if (!params.empty()      ) f << "params="          << params          << endl;
-			if (!manual.empty()      ) f << "manual="          << manual          << endl;
+	stringstream f;
+	if (!isOpk()) {
+		if (!title.empty()       ) f << "title="           << title           << endl;
+		if (!description.empty() ) f << "description="     << description     << endl;
+		if (!launchMsg.empty()   ) f << "launchmsg="       << launchMsg       << endl;
+		if (!icon.empty()        ) f << "icon="            << icon            << endl;
+		if (!exec.empty()        ) f << "exec="            << exec            << endl;
+		if (!params.empty()      ) f << "params="          << params          << endl;
+		if (!manual.empty()      ) f << "manual="          << manual          << endl;
 #if defined(PLATFORM_A320) || defined(PLATFORM_GCW0)
-			if (consoleApp           ) f << "consoleapp=true"                     << endl;
+		if (consoleApp           ) f << "consoleapp=true"                     << endl;
 #endif
-			if (selectorfilter != "*") f << "selectorfilter="  << selectorfilter  << endl;
-		}
-		if (iclock != 0              ) f << "clock="           << iclock          << endl;
-		if (!selectordir.empty()     ) f << "selectordir="     << selectordir     << endl;
-		if (!selectorbrowser         ) f << "selectorbrowser=false"               << endl;
-		if (!aliasfile.empty()       ) f << "selectoraliases=" << aliasfile       << endl;
-		f.close();
-		sync();
-		return true;
-	} else
-		ERROR("Error while opening the file '%s' for write.\n", file.c_str());
-	return false;
+		if (selectorfilter.str() != "*") f << "selectorfilter="  << selectorfilter  << endl;
+	}
+	if (iclock != 0              ) f << "clock="           << iclock          << endl;
+	if (!selectordir.empty()     ) f << "selectordir="     << selectordir     << endl;
+	if (!selectorbrowser         ) f << "selectorbrowser=false"               << endl;
+	if (!aliasfile.empty()       ) f << "selectoraliases=" << aliasfile       << endl;
+
+	gmenu2x->fileWriter.write(file, f.str());
+	edited = false;
+	return true;
 }
 
 void LinkApp::drawRun() {
@@ -377,8 +372,10 @@ void LinkApp::showManual() {
 	if (manual.empty())
 		return;
 
+	const string &manual = this->manual;
+
 #ifdef HAVE_LIBOPK
-	if (isOPK) {
+	if (isOpk()) {
 		vector<string> readme;
 		char *token, *ptr;
 		struct OPK *opk;
@@ -437,7 +434,7 @@ void LinkApp::showManual() {
 		if (!pngman) {
 			return;
 		}
-		Surface *bg = Surface::loadImage(gmenu2x->confStr["wallpaper"]);
+		Surface *bg = Surface::loadImage(gmenu2x->conf.wallpaper);
 		if (!bg) {
 			bg = Surface::emptySurface(gmenu2x->s->width(), gmenu2x->s->height());
 		}
@@ -453,26 +450,31 @@ void LinkApp::showManual() {
 		string spagecount;
 		ss >> spagecount;
 
+		const string &exitLabel = gmenu2x->tr["Exit"];
+		const string &changePageLabel = gmenu2x->tr["Change page"];
+		const string &pageLabel = gmenu2x->tr["Page"];
+
 #ifdef ENABLE_CPUFREQ
 		//Lower the clock
 		gmenu2x->setMenuClock();
 #endif
 
+		LatencyTrace::Scope scope("Manual");
 		while (!close) {
 			if (repaint) {
 				bg->blit(gmenu2x->s, 0, 0);
 				pngman->blit(gmenu2x->s, -page*320, 0);
 
 				gmenu2x->drawBottomBar(gmenu2x->s);
-				gmenu2x->drawButton(gmenu2x->s, "start", gmenu2x->tr["Exit"],
+				gmenu2x->drawButton(gmenu2x->s, "start", exitLabel,
 				gmenu2x->drawButton(gmenu2x->s, "cancel", "",
-				gmenu2x->drawButton(gmenu2x->s, "right", gmenu2x->tr["Change page"],
+				gmenu2x->drawButton(gmenu2x->s, "right", changePageLabel,
 				gmenu2x->drawButton(gmenu2x->s, "left", "", 5)-10))-10);
 
 				ss.clear();
 				ss << page+1;
 				ss >> pageStatus;
-				pageStatus = gmenu2x->tr["Page"]+": "+pageStatus+"/"+spagecount;
+				pageStatus = pageLabel+": "+pageStatus+"/"+spagecount;
 				gmenu2x->s->write(gmenu2x->font, pageStatus, 310, 230, Font::HAlignRight, Font::VAlignMiddle);
 
 				gmenu2x->s->flip();
@@ -499,6 +501,9 @@ void LinkApp::showManual() {
                 default:
                     break;
             }
+			// A press that changed nothing has no frame to wait for.
+			if (!close && !repaint)
+				LatencyTrace::getInstance().discard();
         }
 		delete bg;
 		return;
@@ -552,6 +557,8 @@ void LinkApp::selector(int startSelection, const string &selectorDir) {
 void LinkApp::launch(const string &selectedFile) {
 	save();
 
+	string exec = this->exec, params = this->params;
+
 	if (!isOpk()) {
 		//Set correct working directory
 		string::size_type pos = exec.rfind("/");
@@ -580,7 +587,7 @@ void LinkApp::launch(const string &selectedFile) {
 		}
 	}
 
-	if (gmenu2x->confInt["outputLogs"]
+	if (gmenu2x->conf.outputLogs
 #if defined(PLATFORM_A320) || defined(PLATFORM_GCW0)
 				&& !consoleApp
 #endif
@@ -602,7 +609,7 @@ void LinkApp::launch(const string &selectedFile) {
 		gmenu2x->writeTmp();
 	}
 #ifdef ENABLE_CPUFREQ
-	if (clock() != gmenu2x->confInt["menuClock"]) {
+	if (clock() != gmenu2x->conf.menuClock) {
 		gmenu2x->setClock(clock());
 	}
 #endif
@@ -679,9 +686,10 @@ const string &LinkApp::getSelectorDir() {
 }
 
 void LinkApp::setSelectorDir(const string &selectordir) {
-	this->selectordir = selectordir;
 	if (!selectordir.empty() && selectordir[selectordir.length() - 1] != '/') {
-		this->selectordir += "/";
+		this->selectordir = selectordir + "/";
+	} else {
+		this->selectordir = selectordir;
 	}
 	edited = true;
 }
@@ -22,6 +22,7 @@
 #define LINKAPP_H
 
 #include "link.h"
+#include "stringpool.h"
 
 #include <string>
 
@@ -34,18 +35,17 @@ Parses links files.
 */
 class LinkApp : public Link {
 private:
-	std::string sclock;
+	PooledString sclock;
 	int iclock;
-	std::string exec, params, workdir, manual, selectordir, selectorfilter;
+	PooledString exec, params, manual, selectordir, selectorfilter;
 	bool selectorbrowser, editable;
 
-	std::string aliasfile;
-	std::string file;
+	PooledString aliasfile;
+	PooledString file;
 
 	bool dontleave;
 #ifdef HAVE_LIBOPK
-	bool isOPK;
-	std::string opkMount, opkFile, category, metadata;
+	PooledString opkMount, opkFile, category, metadata;
 #endif
 
 	void start();
@@ -56,15 +56,14 @@ protected:
 public:
 #ifdef HAVE_LIBOPK
 	const std::string &getCategory() { return category; }
-	bool isOpk() { return isOPK; }
 	const std::string &getOpkFile() { return opkFile; }
 
 	LinkApp(GMenu2X *gmenu2x, const char* linkfile,
 				struct OPK *opk = NULL, const char *metadata = NULL);
 #else
 	LinkApp(GMenu2X *gmenu2x, const char* linkfile);
-	bool isOpk() { return false; }
 #endif
+	bool isOpk() { return type == Type::OPK; }
 
 	virtual void loadIcon();
 
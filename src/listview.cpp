@@ -0,0 +1,189 @@
+#include "listview.h"
+
+#include "font.h"
+#include "gmenu2x.h"
+#include "surface.h"
+
+using namespace std;
+
+ListView::ListView(GMenu2X *gmenu2x)
+	: gmenu2x(gmenu2x)
+	, rowHeight(1)
+	, rowsPerPage(1)
+	, selectionWidth(0)
+	, count(0)
+	, selected(0)
+	, first(0)
+	, cursor(true)
+{
+	area.x = area.y = 0;
+	area.w = area.h = 0;
+}
+
+ListView::~ListView()
+{
+}
+
+void ListView::setArea(SDL_Rect area, unsigned int rowHeight)
+{
+	this->area = area;
+	this->rowHeight = rowHeight ? rowHeight : 1;
+	rowsPerPage = max(area.h / this->rowHeight, 1u);
+	selectionWidth = area.w - 2;
+	setSize(count);
+}
+
+void ListView::setSize(unsigned int count)
+{
+	this->count = count;
+	if (selected >= count)
+		selected = count ? count - 1 : 0;
+	setFirst(first);
+	if (cursor)
+		scrollTo(selected);
+}
+
+void ListView::invalidate()
+{
+	rendered.clear();
+}
+
+void ListView::setSelected(unsigned int i)
+{
+	selected = i < count ? i : 0;
+	scrollTo(selected);
+}
+
+void ListView::setFirst(unsigned int i)
+{
+	const unsigned int last = count > rowsPerPage ? count - rowsPerPage : 0;
+	first = min(i, last);
+}
+
+void ListView::scrollTo(unsigned int i)
+{
+	if (i < first)
+		first = i;
+	else if (i >= first + rowsPerPage)
+		first = i - rowsPerPage + 1;
+}
+
+void ListView::up()
+{
+	if (!cursor) {
+		if (first > 0)
+			first--;
+	} else if (count) {
+		selected = selected ? selected - 1 : count - 1;
+		scrollTo(selected);
+	}
+}
+
+void ListView::down()
+{
+	if (!cursor) {
+		setFirst(first + 1);
+	} else if (count) {
+		selected = selected + 1 < count ? selected + 1 : 0;
+		scrollTo(selected);
+	}
+}
+
+void ListView::pageUp()
+{
+	const unsigned int step = rowsPerPage > 1 ? rowsPerPage - 1 : 1;
+	if (!cursor) {
+		first = first > step ? first - step : 0;
+	} else if (count) {
+		selected = selected > step ? selected - step : 0;
+		scrollTo(selected);
+	}
+}
+
+void ListView::pageDown()
+{
+	const unsigned int step = rowsPerPage > 1 ? rowsPerPage - 1 : 1;
+	if (!cursor) {
+		setFirst(first + step);
+	} else if (count) {
+		selected = min(selected + step, count - 1);
+		scrollTo(selected);
+	}
+}
+
+int ListView::getRowY(unsigned int i) const
+{
+	return area.y + ((int) i - (int) first) * (int) rowHeight;
+}
+
+int ListView::rowAt(int x, int y) const
+{
+	if (x < area.x || x >= area.x + area.w || y < area.y)
+		return -1;
+
+	const unsigned int row = (y - area.y) / rowHeight;
+	if (row >= rowsPerPage || first + row >= count)
+		return -1;
+	return first + row;
+}
+
+Surface *ListView::getLabel(unsigned int i)
+{
+	auto it = rendered.find(i);
+	if (it != rendered.end())
+		return it->second.get();
+
+	Surface *label = labels ? gmenu2x->font->render(labels(i)) : nullptr;
+	rendered[i].reset(label);
+	return label;
+}
+
+void ListView::dropHiddenLabels()
+{
+	/* Keep the labels of the page above and the page below, so that
+	 * going back and forth does not render them again. */
+	if (rendered.size() <= 3 * rowsPerPage)
+		return;
+
+	const unsigned int from = first > rowsPerPage ? first - rowsPerPage : 0;
+	const unsigned int to = first + 2 * rowsPerPage;
+	for (auto it = rendered.begin(); it != rendered.end(); ) {
+		if (it->first < from || it->first >= to)
+			it = rendered.erase(it);
+		else
+			++it;
+	}
+}
+
+void ListView::paint(Surface *s)
+{
+	s->setClipRect(area);
+
+	if (cursor && selected < count)
+		s->box(area.x + 1, getRowY(selected), selectionWidth, rowHeight,
+					gmenu2x->skinConfColors[COLOR_SELECTION_BG]);
+
+	const unsigned int last = min(count, first + rowsPerPage);
+	for (unsigned int i = first; i < last; i++) {
+		const int y = getRowY(i);
+		if (painter && painter(s, i, y))
+			continue;
+
+		int x = area.x + 4;
+		Surface *icon = icons ? icons(i) : nullptr;
+		if (icon) {
+			icon->blit(s, x, y + ((int) rowHeight - icon->height()) / 2);
+			x += icon->width() + 2;
+		}
+
+		Surface *label = getLabel(i);
+		if (label)
+			label->blit(s, x - 1,
+						y + ((int) rowHeight - label->height()) / 2);
+	}
+
+	s->clearClipRect();
+
+	gmenu2x->drawScrollBar(rowsPerPage, count, first);
+	dropHiddenLabels();
+}
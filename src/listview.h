@@ -0,0 +1,98 @@
+#ifndef LISTVIEW_H
+#define LISTVIEW_H
+
+#include <SDL.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class GMenu2X;
+class Surface;
+
+/**
+ * A scrolling list of rows with a cursor, shared by the list dialogs.
+ *
+ * Only the visible rows are painted. The label of a row is rendered once
+ * and kept for as long as the row stays near the visible page, so moving
+ * the cursor repaints from cached labels and scrolling by one row renders
+ * a single new one.
+ */
+class ListView {
+public:
+	/** Returns the text of row "i". */
+	typedef std::function<std::string(unsigned int i)> LabelFunction;
+	/** Returns the icon shown before the label of row "i", or NULL. */
+	typedef std::function<Surface *(unsigned int i)> IconFunction;
+	/**
+	 * Paints row "i" at height "y". Returns false to have its icon and
+	 * label painted instead.
+	 */
+	typedef std::function<bool(Surface *s, unsigned int i, int y)> PaintFunction;
+
+	ListView(GMenu2X *gmenu2x);
+	~ListView();
+
+	/**
+	 * Sets the part of the screen that the rows are painted in; the rows
+	 * that do not fit entirely are not shown.
+	 */
+	void setArea(SDL_Rect area, unsigned int rowHeight);
+	void setLabels(LabelFunction labels) { this->labels = labels; }
+	void setIcons(IconFunction icons) { this->icons = icons; }
+	void setPainter(PaintFunction painter) { this->painter = painter; }
+	/** Limits the selection bar to the first "width" pixels of a row. */
+	void setSelectionWidth(unsigned int width) { selectionWidth = width; }
+	/**
+	 * Without a cursor nothing is selected, and moving up and down scrolls
+	 * the rows instead.
+	 */
+	void setCursor(bool cursor) { this->cursor = cursor; }
+
+	unsigned int size() const { return count; }
+	void setSize(unsigned int count);
+	/** Forgets the rendered labels, after rows were changed or moved. */
+	void invalidate();
+
+	unsigned int getSelected() const { return selected; }
+	/** Selects row "i" and scrolls it into view. */
+	void setSelected(unsigned int i);
+	unsigned int getFirst() const { return first; }
+	/** Scrolls row "i" to the top, or as close as the list allows. */
+	void setFirst(unsigned int i);
+	unsigned int getRowsPerPage() const { return rowsPerPage; }
+
+	/** Moves up or down by one row, wrapping around at the ends. */
+	void up();
+	void down();
+	/** Moves by one page, keeping one row of the previous page visible. */
+	void pageUp();
+	void pageDown();
+
+	int getRowY(unsigned int i) const;
+	/** Returns the visible row at screen position (x, y), or -1. */
+	int rowAt(int x, int y) const;
+
+	/** Paints the visible rows, the selection bar and the scroll bar. */
+	void paint(Surface *s);
+
+private:
+	Surface *getLabel(unsigned int i);
+	void scrollTo(unsigned int i);
+	void dropHiddenLabels();
+
+	GMenu2X *gmenu2x;
+	LabelFunction labels;
+	IconFunction icons;
+	PaintFunction painter;
+
+	SDL_Rect area;
+	unsigned int rowHeight, rowsPerPage, selectionWidth;
+	unsigned int count, selected, first;
+	bool cursor;
+
+	/* Rendered labels by row; NULL for rows without text. */
+	std::unordered_map<unsigned int, std::unique_ptr<Surface>> rendered;
+};
+
+#endif
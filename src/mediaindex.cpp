@@ -0,0 +1,443 @@
+#include "mediaindex.h"
+
+#include "debug.h"
+#include "dircache.h"
+#include "filefilter.h"
+#include "gmenu2x.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_set>
+
+using namespace std;
+
+static const char *FILE_HEADER = "gmenu2x media index 2";
+
+/* Pause after reading a directory, and after every few directories that
+ * were only checked, so that the crawler never keeps the disk busy. */
+static const useconds_t READ_DELAY = 5000;
+static const useconds_t CHECK_DELAY = 1000;
+static const unsigned int CHECKS_PER_DELAY = 32;
+
+/* Number of directories read between two snapshots during a long crawl,
+ * so that the first results show up before it is over. */
+static const unsigned int READS_PER_PUBLISH = 256;
+
+static bool isBelow(const string &path, const string &root)
+{
+	return !path.compare(0, root.size(), root);
+}
+
+pair<vector<shared_ptr<const IndexedDir>>::const_iterator,
+		vector<shared_ptr<const IndexedDir>>::const_iterator>
+MediaSnapshot::below(const string &path) const
+{
+	auto first = lower_bound(dirs.begin(), dirs.end(), path,
+			[](const shared_ptr<const IndexedDir> &dir, const string &path) {
+				return dir->path < path;
+			});
+	// All the paths that start with "path" sort right after it.
+	auto last = find_if(first, dirs.end(),
+			[&path](const shared_ptr<const IndexedDir> &dir) {
+				return !isBelow(dir->path, path);
+			});
+	return make_pair(first, last);
+}
+
+bool MediaSnapshot::contains(const string &path) const
+{
+	auto range = below(path);
+	return range.first != range.second && (*range.first)->path == path;
+}
+
+unsigned int MediaSnapshot::countFiles(
+		const string &path, const FileFilter &filter) const
+{
+	unsigned int count = 0;
+	auto range = below(path);
+	for (auto it = range.first; it != range.second; ++it) {
+		const vector<string> &files = (*it)->files;
+		if (filter.matchesAll()) {
+			count += files.size();
+		} else {
+			for (auto &file : files)
+				count += filter.matches(file);
+		}
+	}
+	return count;
+}
+
+MediaIndex &MediaIndex::getInstance()
+{
+	static MediaIndex instance;
+	return instance;
+}
+
+MediaIndex::MediaIndex()
+	: started(false)
+	, quitting(false)
+	, snapshot(make_shared<MediaSnapshot>())
+	, changed(false)
+	, unsaved(false)
+{
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&queued, NULL);
+}
+
+MediaIndex::~MediaIndex()
+{
+	stop();
+	pthread_cond_destroy(&queued);
+	pthread_mutex_destroy(&mutex);
+}
+
+void MediaIndex::start(const vector<string> &paths)
+{
+	if (started)
+		return;
+
+	/* Crawl every folder once, even if it is below several roots. */
+	roots.clear();
+	for (auto path : paths) {
+		if (path.empty())
+			continue;
+		if (path[path.length() - 1] != '/')
+			path += '/';
+		roots.push_back(path);
+	}
+	sort(roots.begin(), roots.end());
+	roots.erase(unique(roots.begin(), roots.end(),
+				[](const string &a, const string &b) {
+					return isBelow(b, a);
+				}), roots.end());
+
+	started = !pthread_create(&thread, NULL, threadMain, this);
+	if (!started)
+		ERROR("Unable to create media indexer thread\n");
+}
+
+void MediaIndex::stop()
+{
+	pthread_mutex_lock(&mutex);
+	quitting = true;
+	pthread_cond_signal(&queued);
+	pthread_mutex_unlock(&mutex);
+
+	if (started) {
+		pthread_join(thread, NULL);
+		started = false;
+	}
+}
+
+void MediaIndex::rescan(const string &path)
+{
+	queue(path, false);
+}
+
+void MediaIndex::remove(const string &path)
+{
+	queue(path, true);
+}
+
+void MediaIndex::queue(const string &path, bool remove)
+{
+	Job job = { path, remove };
+	if (job.path.empty() || job.path[job.path.length() - 1] != '/')
+		job.path += '/';
+
+	pthread_mutex_lock(&mutex);
+	jobs.push_back(job);
+	pthread_cond_signal(&queued);
+	pthread_mutex_unlock(&mutex);
+}
+
+shared_ptr<const MediaSnapshot> MediaIndex::getSnapshot()
+{
+	pthread_mutex_lock(&mutex);
+	shared_ptr<const MediaSnapshot> current = snapshot;
+	pthread_mutex_unlock(&mutex);
+	return current;
+}
+
+bool MediaIndex::isQuitting()
+{
+	pthread_mutex_lock(&mutex);
+	bool ret = quitting;
+	pthread_mutex_unlock(&mutex);
+	return ret;
+}
+
+void *MediaIndex::threadMain(void *p)
+{
+	static_cast<MediaIndex *>(p)->run();
+	return NULL;
+}
+
+void MediaIndex::run()
+{
+	// The nice value of a Linux thread is its own.
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+
+	load();
+	publish();
+	unsaved = false; // nothing new yet
+
+	bool complete = true;
+	for (auto &root : roots) {
+		if (!crawl(root)) {
+			complete = false;
+			break;
+		}
+	}
+	if (complete)
+		forgetOutsideRoots();
+	publish();
+	save();
+
+	pthread_mutex_lock(&mutex);
+	while (!quitting) {
+		if (jobs.empty()) {
+			pthread_cond_wait(&queued, &mutex);
+			continue;
+		}
+
+		Job job = jobs.front();
+		jobs.pop_front();
+		pthread_mutex_unlock(&mutex);
+
+		if (job.remove)
+			forget(job.path);
+		else
+			crawl(job.path);
+		publish();
+		save();
+
+		pthread_mutex_lock(&mutex);
+	}
+	pthread_mutex_unlock(&mutex);
+
+	publish();
+	save();
+}
+
+bool MediaIndex::crawl(const string &root)
+{
+	DEBUG("Indexing '%s'\n", root.c_str());
+
+	/* Symbolic links below the root are not followed, so that a folder is
+	 * not indexed twice under different paths. Directories are recognized
+	 * by inode too, in case a bind mount leads back to a parent. */
+	set<pair<dev_t, ino_t>> visited;
+	unordered_set<string> seen;
+	vector<string> pending(1, root);
+	unsigned int reads = 0, checks = 0;
+
+	while (!pending.empty()) {
+		if (isQuitting())
+			return false;
+
+		const string path = pending.back();
+		pending.pop_back();
+
+		struct stat st;
+		// Without its trailing slash, as lstat() would follow the link.
+		int ret = path == root ? stat(path.c_str(), &st)
+			: lstat(path.substr(0, path.length() - 1).c_str(), &st);
+		if (ret || !S_ISDIR(st.st_mode)
+				|| !visited.insert(make_pair(st.st_dev, st.st_ino)).second)
+			continue;
+		seen.insert(path);
+
+		shared_ptr<const IndexedDir> dir;
+		auto it = dirs.find(path);
+		if (it != dirs.end()
+				&& it->second->mtime.tv_sec == st.st_mtim.tv_sec
+				&& it->second->mtime.tv_nsec == st.st_mtim.tv_nsec
+				&& DirCache::isSettled(it->second->mtime,
+						it->second->listedAt)) {
+			dir = it->second;
+			if (++checks % CHECKS_PER_DELAY == 0)
+				usleep(CHECK_DELAY);
+		} else {
+			const time_t listedAt = time(NULL);
+			shared_ptr<DirListing> listing = DirCache::read(path);
+			if (!listing)
+				continue;
+
+			shared_ptr<IndexedDir> fresh = make_shared<IndexedDir>();
+			fresh->path = path;
+			fresh->mtime = st.st_mtim;
+			fresh->listedAt = listedAt;
+			fresh->files.swap(listing->files);
+			for (auto &name : listing->directories) {
+				if (name != "..")
+					fresh->directories.push_back(name);
+			}
+			dir = fresh;
+			dirs[path] = dir;
+			changed = true;
+
+			if (++reads % READS_PER_PUBLISH == 0)
+				publish();
+			usleep(READ_DELAY);
+		}
+
+		// Reversed, so that the folders are crawled in order.
+		for (auto sub = dir->directories.rbegin();
+				sub != dir->directories.rend(); ++sub)
+			pending.push_back(path + *sub + "/");
+	}
+
+	// Forget the directories that are gone.
+	for (auto it = dirs.lower_bound(root);
+			it != dirs.end() && isBelow(it->first, root); ) {
+		if (seen.count(it->first)) {
+			++it;
+		} else {
+			it = dirs.erase(it);
+			changed = true;
+		}
+	}
+
+	DEBUG("Indexed '%s': %u folders read, %u unchanged\n",
+			root.c_str(), reads, checks);
+	return true;
+}
+
+void MediaIndex::forget(const string &path)
+{
+	auto first = dirs.lower_bound(path);
+	auto last = first;
+	while (last != dirs.end() && isBelow(last->first, path))
+		++last;
+	if (first != last) {
+		dirs.erase(first, last);
+		changed = true;
+	}
+}
+
+void MediaIndex::forgetOutsideRoots()
+{
+	for (auto it = dirs.begin(); it != dirs.end(); ) {
+		bool kept = any_of(roots.begin(), roots.end(),
+				[&it](const string &root) {
+					return isBelow(it->first, root);
+				});
+		if (kept) {
+			++it;
+		} else {
+			it = dirs.erase(it);
+			changed = true;
+		}
+	}
+}
+
+void MediaIndex::publish()
+{
+	if (!changed)
+		return;
+	changed = false;
+	unsaved = true;
+
+	shared_ptr<MediaSnapshot> fresh = make_shared<MediaSnapshot>();
+	fresh->dirs.reserve(dirs.size());
+	fresh->fileCount = 0;
+	for (auto &it : dirs) {
+		fresh->dirs.push_back(it.second);
+		fresh->fileCount += it.second->files.size();
+	}
+
+	pthread_mutex_lock(&mutex);
+	snapshot = fresh;
+	pthread_mutex_unlock(&mutex);
+
+	DEBUG("Media index: %u files in %u folders\n",
+			fresh->fileCount, (unsigned int) fresh->dirs.size());
+	inject_user_event();
+}
+
+/* The index file has one "D <mtime> <nsec> <listed at> <path>" line per
+ * directory, followed by a "d <name>" line per subdirectory and an
+ * "f <name>" line per file. */
+
+void MediaIndex::load()
+{
+	const string path = GMenu2X::getHome() + "/mediaindex";
+	ifstream in(path.c_str());
+	string line;
+	if (!getline(in, line) || line != FILE_HEADER)
+		return;
+
+	shared_ptr<IndexedDir> dir;
+	while (getline(in, line)) {
+		bool valid = line.size() > 2 && line[1] == ' ';
+		if (valid && line[0] == 'D') {
+			char *end;
+			dir = make_shared<IndexedDir>();
+			dir->mtime.tv_sec = strtoll(line.c_str() + 2, &end, 10);
+			dir->mtime.tv_nsec = strtol(end, &end, 10);
+			dir->listedAt = strtoll(end, &end, 10);
+			dir->path = *end == ' ' ? end + 1 : "";
+			valid = !dir->path.empty();
+			if (valid)
+				dirs[dir->path] = dir;
+		} else if (valid && dir && line[0] == 'd') {
+			dir->directories.push_back(line.substr(2));
+		} else if (valid && dir && line[0] == 'f') {
+			dir->files.push_back(line.substr(2));
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			WARNING("Ignoring damaged media index '%s'\n", path.c_str());
+			dirs.clear();
+			return;
+		}
+	}
+
+	changed = !dirs.empty();
+}
+
+void MediaIndex::save()
+{
+	if (!unsaved)
+		return;
+	unsaved = false;
+
+	const string path = GMenu2X::getHome() + "/mediaindex";
+	const string tmp = path + ".tmp";
+	ofstream out(tmp.c_str(), ios_base::out | ios_base::trunc);
+	out << FILE_HEADER << '\n';
+	for (auto &it : dirs) {
+		const IndexedDir &dir = *it.second;
+		// One name per line: a name with a newline cannot be saved.
+		if (dir.path.find('\n') != string::npos)
+			continue;
+
+		out << "D " << (long long) dir.mtime.tv_sec << ' '
+			<< dir.mtime.tv_nsec << ' ' << (long long) dir.listedAt << ' '
+			<< dir.path << '\n';
+		for (auto &name : dir.directories) {
+			if (name.find('\n') == string::npos)
+				out << "d " << name << '\n';
+		}
+		for (auto &name : dir.files) {
+			if (name.find('\n') == string::npos)
+				out << "f " << name << '\n';
+		}
+	}
+	out.close();
+
+	if (out.fail() || rename(tmp.c_str(), path.c_str())) {
+		WARNING("Unable to save media index '%s'\n", path.c_str());
+		unlink(tmp.c_str());
+	}
+}
@@ -0,0 +1,117 @@
+#ifndef MEDIAINDEX_H
+#define MEDIAINDEX_H
+
+#include <ctime>
+#include <deque>
+#include <map>
+#include <memory>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+class FileFilter;
+
+/** The entries of one indexed directory, in collation order. */
+struct IndexedDir {
+	std::string path; // ends with a '/'
+	struct timespec mtime;
+	time_t listedAt; // see DirCache::isSettled()
+	std::vector<std::string> files, directories;
+};
+
+/**
+ * The contents of the index at one point in time. A snapshot never changes:
+ * the index publishes a new one whenever it has learned something.
+ */
+struct MediaSnapshot {
+	/** The indexed directories, sorted by path. */
+	std::vector<std::shared_ptr<const IndexedDir>> dirs;
+	unsigned int fileCount;
+
+	/**
+	 * Returns the directories below "path" (which must end with a '/'),
+	 * including "path" itself, as a range of "dirs".
+	 */
+	std::pair<std::vector<std::shared_ptr<const IndexedDir>>::const_iterator,
+			std::vector<std::shared_ptr<const IndexedDir>>::const_iterator>
+		below(const std::string &path) const;
+
+	/** Returns true if "path" (which must end with a '/') was indexed. */
+	bool contains(const std::string &path) const;
+
+	/**
+	 * Returns the number of files in "path" and its subdirectories that
+	 * pass "filter".
+	 */
+	unsigned int countFiles(const std::string &path,
+			const FileFilter &filter) const;
+};
+
+/**
+ * Index of the files on the storage, kept up to date by a background
+ * thread so that file counts and searches never wait for the disk.
+ *
+ * The crawler runs at the lowest priority and pauses between directories.
+ * A directory whose modification time did not change since it was indexed
+ * costs a single stat(), so crawling again after a restart is cheap: the
+ * index is saved to the gmenu2x home directory and loaded on the next run.
+ */
+class MediaIndex {
+public:
+	static MediaIndex &getInstance();
+
+	/**
+	 * Loads the index saved by the previous run and starts crawling
+	 * "roots" in the background. Directories that are not below any of
+	 * the roots are forgotten once the crawl is over.
+	 */
+	void start(const std::vector<std::string> &roots);
+	/** Stops crawling and saves the index; this can take a moment. */
+	void stop();
+
+	/** Crawls "path" and what is below it again, e.g. a card that was inserted. */
+	void rescan(const std::string &path);
+	/** Forgets "path" and what is below it, e.g. a card that was removed. */
+	void remove(const std::string &path);
+
+	/** Returns the current contents of the index; never NULL. */
+	std::shared_ptr<const MediaSnapshot> getSnapshot();
+
+private:
+	struct Job {
+		std::string path;
+		bool remove;
+	};
+	typedef std::map<std::string, std::shared_ptr<const IndexedDir>> DirMap;
+
+	MediaIndex();
+	~MediaIndex();
+
+	static void *threadMain(void *p);
+	void run();
+	bool isQuitting();
+	void queue(const std::string &path, bool remove);
+
+	bool crawl(const std::string &root);
+	void forget(const std::string &path);
+	void forgetOutsideRoots();
+	void publish();
+	void load();
+	void save();
+
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t queued;
+	bool started, quitting;
+
+	/* Guarded by "mutex". */
+	std::deque<Job> jobs;
+	std::shared_ptr<const MediaSnapshot> snapshot;
+
+	/* Owned by the worker thread. */
+	std::vector<std::string> roots;
+	DirMap dirs;
+	bool changed, unsaved;
+};
+
+#endif
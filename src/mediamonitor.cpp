@@ -5,6 +5,7 @@
 
 #include "debug.h"
 #include "inputmanager.h"
+#include "mediaindex.h"
 #include "mediamonitor.h"
 #include "utilities.h"
 
@@ -25,10 +26,13 @@ void MediaMonitor::inject_event(bool is_add, const char *path)
 	 * on the mountpoint before we start looking for OPKs */
 	sleep(1);
 
-	if (is_add)
+	if (is_add) {
+		MediaIndex::getInstance().rescan(path);
 		inject_user_event(OPEN_PACKAGES_FROM_DIR, strdup(path));
-	else
+	} else {
+		MediaIndex::getInstance().remove(path);
 		inject_user_event(REMOVE_LINKS, strdup(path));
+	}
 }
 
 #endif /* ENABLE_INOTIFY */
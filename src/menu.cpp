@@ -36,7 +36,10 @@
 #include "linkapp.h"
 #include "menu.h"
 #include "monitor.h"
+#include "collation.h"
+#include "filefilter.h"
 #include "filelister.h"
+#include "mediaindex.h"
 #include "utilities.h"
 #include "debug.h"
 #include "iconbutton.h"
@@ -44,38 +47,52 @@
 using namespace std;
 
 
+/* The distance left to slide, plus one section, decays exponentially with
+ * this time constant in milliseconds: the speed that losing 1/32 of it per
+ * frame at 60 frames per second used to give. */
+static const double SLIDE_TIME_CONSTANT = 1000.0 / 60 / log(32.0 / 31.0);
+
 Menu::Animation::Animation()
 	: curr(0)
+	, from(0)
+	, tickStart(0)
 {
 }
 
 void Menu::Animation::adjust(int delta)
 {
+	if (curr != 0)
+		step();
 	curr += delta;
+	from = curr;
+	tickStart = SDL_GetTicks();
 }
 
 void Menu::Animation::step()
 {
 	if (curr == 0) {
 		ERROR("Computing step past animation end\n");
-	} else if (curr < 0) {
-		const int v = ((1 << 16) - curr) / 32;
-		curr = std::min(0, curr + v);
-	} else {
-		const int v = ((1 << 16) + curr) / 32;
-		curr = std::max(0, curr - v);
+		return;
 	}
+
+	const long elapsed = SDL_GetTicks() - tickStart;
+	const double left = (abs(from) + (1 << 16))
+			* exp(-elapsed / SLIDE_TIME_CONSTANT) - (1 << 16);
+	const int value = left > 0 ? static_cast<int>(left) : 0;
+	curr = from < 0 ? -value : value;
 }
 
 Menu::Menu(GMenu2X *gmenu2x, Touchscreen &ts)
 	: gmenu2x(gmenu2x)
 	, ts(ts)
 	, btnContextMenu(new IconButton(gmenu2x, ts, "skin:imgs/menu.png"))
+	, linksGeneration(0)
 {
 	readSections(GMENU2X_SYSTEM_DIR "/sections");
 	readSections(GMenu2X::getHome() + "/sections");
 
-	sort(sections.begin(),sections.end(),case_less());
+	collationSort(sections);
+	rebuildSectionIndex();
 	setSectionIndex(0);
 	readLinks();
 
@@ -108,10 +125,23 @@ Menu::~Menu() {
 
 #ifdef ENABLE_INOTIFY
 	for (auto it : monitors)
-		delete it;
+		delete it.second;
 #endif
 }
 
+void Menu::rebuildSectionIndex()
+{
+	sectionIndex.clear();
+	for (uint i = 0; i < sections.size(); i++)
+		sectionIndex[sections[i]] = i;
+}
+
+int Menu::sectionNamed(const string &name)
+{
+	unordered_map<string, uint>::const_iterator it = sectionIndex.find(name);
+	return it == sectionIndex.end() ? -1 : (int) it->second;
+}
+
 void Menu::readSections(std::string parentDir)
 {
 	DIR *dirp;
@@ -124,12 +154,11 @@ void Menu::readSections(std::string parentDir)
 		if (dptr->d_name[0] == '.' || dptr->d_type != DT_DIR)
 			continue;
 
-		string filepath = parentDir + "/" + dptr->d_name;
-
-		if (find(sections.begin(), sections.end(), (string)dptr->d_name) == sections.end()) {
-			sections.push_back((string)dptr->d_name);
-			vector<Link*> ll;
-			links.push_back(ll);
+		string name = dptr->d_name;
+		if (sectionIndex.find(name) == sectionIndex.end()) {
+			sectionIndex[name] = sections.size();
+			sections.push_back(name);
+			links.push_back(vector<Link*>());
 		}
 	}
 
@@ -137,11 +166,11 @@ void Menu::readSections(std::string parentDir)
 }
 
 void Menu::skinUpdated() {
-	ConfIntHash &skinConfInt = gmenu2x->skinConfInt;
+	const SkinConfig &skinConf = gmenu2x->skinConf;
 
 	//recalculate some coordinates based on the new element sizes
-	linkColumns = (gmenu2x->resX - 10) / skinConfInt["linkWidth"];
-	linkRows = (gmenu2x->resY - 35 - skinConfInt["topBarHeight"]) / skinConfInt["linkHeight"];
+	linkColumns = (gmenu2x->resX - 10) / skinConf.linkWidth;
+	linkRows = (gmenu2x->resY - 35 - skinConf.topBarHeight) / skinConf.linkHeight;
 
 	//reload section icons
 	vector<string>::size_type i = 0;
@@ -159,8 +188,8 @@ void Menu::skinUpdated() {
 }
 
 void Menu::calcSectionRange(int &leftSection, int &rightSection) {
-	ConfIntHash &skinConfInt = gmenu2x->skinConfInt;
-	const int linkWidth = skinConfInt["linkWidth"];
+	const SkinConfig &skinConf = gmenu2x->skinConf;
+	const int linkWidth = skinConf.linkWidth;
 	const int screenWidth = gmenu2x->resX;
 	const int numSections = sections.size();
 	rightSection = min(
@@ -183,11 +212,11 @@ void Menu::paint(Surface &s) {
 	Font &font = *gmenu2x->font;
 	SurfaceCollection &sc = gmenu2x->sc;
 
-	ConfIntHash &skinConfInt = gmenu2x->skinConfInt;
-	const int topBarHeight = skinConfInt["topBarHeight"];
-	const int bottomBarHeight = skinConfInt["bottomBarHeight"];
-	const int linkWidth = skinConfInt["linkWidth"];
-	const int linkHeight = skinConfInt["linkHeight"];
+	const SkinConfig &skinConf = gmenu2x->skinConf;
+	const int topBarHeight = skinConf.topBarHeight;
+	const int bottomBarHeight = skinConf.bottomBarHeight;
+	const int linkWidth = skinConf.linkWidth;
+	const int linkHeight = skinConf.linkHeight;
 	RGBAColor &selectionBgColor = gmenu2x->skinConfColors[COLOR_SELECTION_BG];
 
 	// Apply section header animation.
@@ -244,25 +273,26 @@ void Menu::paint(Surface &s) {
 		const int ir = i - iFirstDispRow * linkColumns;
 		const int x = linkMarginX + (ir % linkColumns) * (linkWidth + linkSpacingX);
 		const int y = ir / linkColumns * (linkHeight + linkSpacingY) + topBarHeight + 2;
-		sectionLinks.at(i)->setPosition(x, y);
+		Link *link = sectionLinks[i];
+		link->setPosition(x, y);
 
 		if (i == (uint)iLink) {
-			sectionLinks.at(i)->paintHover();
+			link->paintHover();
 		}
 
-		sectionLinks.at(i)->paint();
+		link->paint();
 	}
 
+	LinkApp *linkApp = selLinkApp();
 	if (selLink()) {
-		s.write(&font, selLink()->getDescription(),
+		s.write(&font, selLink()->getDescription() + fileCountOf(linkApp),
 				width / 2, height - bottomBarHeight + 2,
 				Font::HAlignCenter, Font::VAlignBottom);
 	}
 
-	LinkApp *linkApp = selLinkApp();
 	if (linkApp) {
 #ifdef ENABLE_CPUFREQ
-		s.write(&font, linkApp->clockStr(gmenu2x->confInt["maxClock"]),
+		s.write(&font, linkApp->clockStr(gmenu2x->conf.maxClock),
 				gmenu2x->cpuX, gmenu2x->bottomBarTextY,
 				Font::HAlignLeft, Font::VAlignMiddle);
 #endif
@@ -311,15 +341,15 @@ bool Menu::handleButtonPress(InputManager::Button button) {
 bool Menu::handleTouchscreen(Touchscreen &ts) {
 	btnContextMenu->handleTS();
 
-	ConfIntHash &skinConfInt = gmenu2x->skinConfInt;
-	const int topBarHeight = skinConfInt["topBarHeight"];
+	const SkinConfig &skinConf = gmenu2x->skinConf;
+	const int topBarHeight = skinConf.topBarHeight;
 	const int screenWidth = gmenu2x->resX;
 
 	if (ts.pressed() && ts.getY() < topBarHeight) {
 		int leftSection, rightSection;
 		calcSectionRange(leftSection, rightSection);
 
-		const int linkWidth = skinConfInt["linkWidth"];
+		const int linkWidth = skinConf.linkWidth;
 		const int leftSectionX = screenWidth / 2 + leftSection * linkWidth;
 		const int i = min(
 				leftSection + max((ts.getX() - leftSectionX) / linkWidth, 0),
@@ -400,7 +430,7 @@ bool Menu::addActionLink(uint section, const string &title, function_t action, c
 	if (section>=sections.size()) return false;
 
 	Link *link = new Link(gmenu2x, action);
-	link->setSize(gmenu2x->skinConfInt["linkWidth"], gmenu2x->skinConfInt["linkHeight"]);
+	link->setSize(gmenu2x->skinConf.linkWidth, gmenu2x->skinConf.linkHeight);
 	link->setTitle(title);
 	link->setDescription(description);
 	if (gmenu2x->sc.exists(icon) || (icon.substr(0,5)=="skin:" && !gmenu2x->sc.getSkinFilePath(icon.substr(5,icon.length())).empty()) || fileExists(icon))
@@ -413,7 +443,7 @@ bool Menu::addActionLink(uint section, const string &title, function_t action, c
 bool Menu::addLink(string path, string file, string section) {
 	if (section.empty()) {
 		section = selSection();
-	} else if (find(sections.begin(),sections.end(),section)==sections.end()) {
+	} else if (sectionNamed(section) < 0) {
 		//section directory doesn't exists
 		if (!addSection(section))
 			return false;
@@ -480,34 +510,30 @@ bool Menu::addLink(string path, string file, string section) {
 	if (fileExists(exename+".png")) icon = exename+".png";
 
 	//Reduce title lenght to fit the link width
-	if (gmenu2x->font->getTextWidth(shorttitle)>gmenu2x->skinConfInt["linkWidth"]) {
-		while (gmenu2x->font->getTextWidth(shorttitle+"..")>gmenu2x->skinConfInt["linkWidth"])
+	if (gmenu2x->font->getTextWidth(shorttitle)>gmenu2x->skinConf.linkWidth) {
+		while (gmenu2x->font->getTextWidth(shorttitle+"..")>gmenu2x->skinConf.linkWidth)
 			shorttitle = shorttitle.substr(0,shorttitle.length()-1);
 		shorttitle += "..";
 	}
 
-	ofstream f(linkpath.c_str());
-	if (f.is_open()) {
-		f << "title=" << shorttitle << endl;
-		f << "exec=" << exec << endl;
-		if (!description.empty()) f << "description=" << description << endl;
-		if (!icon.empty()) f << "icon=" << icon << endl;
-		if (!manual.empty()) f << "manual=" << manual << endl;
-		f.close();
- 		sync();
-		int isection = find(sections.begin(),sections.end(),section) - sections.begin();
-		if (isection>=0 && isection<(int)sections.size()) {
+	stringstream f;
+	f << "title=" << shorttitle << endl;
+	f << "exec=" << exec << endl;
+	if (!description.empty()) f << "description=" << description << endl;
+	if (!icon.empty()) f << "icon=" << icon << endl;
+	if (!manual.empty()) f << "manual=" << manual << endl;
+
+	if (FileWriter::writeNow(linkpath, f.str())) {
+		int isection = sectionNamed(section);
+		if (isection >= 0) {
 
 			INFO("Section: '%s(%i)'\n", sections[isection].c_str(), isection);
 
 			LinkApp* link = new LinkApp(gmenu2x, linkpath.c_str());
-			link->setSize(gmenu2x->skinConfInt["linkWidth"],gmenu2x->skinConfInt["linkHeight"]);
+			link->setSize(gmenu2x->skinConf.linkWidth,gmenu2x->skinConf.linkHeight);
 			links[isection].push_back( link );
 		}
 	} else {
-
-		ERROR("Error while opening the file '%s' for write.\n", linkpath.c_str());
-
 		return false;
 	}
 
@@ -521,9 +547,9 @@ bool Menu::addSection(const string &sectionName) {
 
 	sectiondir = sectiondir + "/" + sectionName;
 	if (mkdir(sectiondir.c_str(), 0755) == 0) {
+		sectionIndex[sectionName] = sections.size();
 		sections.push_back(sectionName);
-		vector<Link*> ll;
-		links.push_back(ll);
+		links.push_back(vector<Link*>());
 		return true;
 	}
 	return false;
@@ -536,10 +562,13 @@ void Menu::deleteSelectedLink()
 
 	INFO("Deleting link '%s'\n", selLink()->getTitle().c_str());
 
-	if (selLinkApp()!=NULL)
+	if (selLinkApp()!=NULL) {
+		gmenu2x->fileWriter.flush();
 		unlink(selLinkApp()->getFile().c_str());
+	}
 	sectionLinks()->erase( sectionLinks()->begin() + selLinkIndex() );
 	setLinkIndex(selLinkIndex());
+	linksGeneration++;
 
 	for (vector< vector<Link*> >::iterator section = links.begin();
 				!icon_used && section<links.end(); section++)
@@ -555,8 +584,19 @@ void Menu::deleteSelectedSection() {
 	INFO("Deleting section '%s'\n", selSection().c_str());
 
 	gmenu2x->sc.del("sections/"+selSection()+".png");
+#ifdef HAVE_LIBOPK
+	for (Link *link : links[selSectionIndex()]) {
+		if (link->getType() == Link::Type::OPK) {
+			LinkApp *app = static_cast<LinkApp *>(link);
+			unindexPackageLink(app);
+			delete app;
+		}
+	}
+#endif
 	links.erase( links.begin()+selSectionIndex() );
 	sections.erase( sections.begin()+selSectionIndex() );
+	linksGeneration++;
+	rebuildSectionIndex();
 	setSectionIndex(0); //reload sections
 }
 
@@ -626,7 +666,70 @@ Link *Menu::selLink() {
 }
 
 LinkApp *Menu::selLinkApp() {
-	return dynamic_cast<LinkApp*>(selLink());
+	Link *link = selLink();
+	return link && link->isApp() ? static_cast<LinkApp *>(link) : NULL;
+}
+
+vector<string> Menu::getSelectorDirs() {
+	vector<string> dirs;
+	for (auto &section : links) {
+		for (Link *link : section) {
+			if (!link->isApp())
+				continue;
+			const string &dir = static_cast<LinkApp *>(link)->getSelectorDir();
+			if (!dir.empty())
+				dirs.push_back(dir);
+		}
+	}
+	return dirs;
+}
+
+vector<Link *> Menu::getLinks() {
+	vector<Link *> all;
+	for (auto &section : links)
+		all.insert(all.end(), section.begin(), section.end());
+	return all;
+}
+
+bool Menu::selectLink(Link *link) {
+	for (uint i = 0; i < links.size(); i++) {
+		auto it = find(links[i].begin(), links[i].end(), link);
+		if (it != links[i].end()) {
+			setSectionIndex(i);
+			setLinkIndex(it - links[i].begin());
+			return true;
+		}
+	}
+	return false;
+}
+
+const string &Menu::fileCountOf(LinkApp *link) {
+	static const string none;
+	if (!link || link->getSelectorDir().empty())
+		return none;
+
+	/* Counting walks all the files below the folder: do it again only
+	 * when the link or the index changed. */
+	shared_ptr<const MediaSnapshot> snapshot =
+			MediaIndex::getInstance().getSnapshot();
+	string dir = link->getSelectorDir();
+	if (dir[dir.length() - 1] != '/')
+		dir += '/';
+	if (snapshot == countedIn && dir == countedDir
+			&& link->getSelectorFilter() == countedFilter)
+		return countText;
+
+	countedIn = snapshot;
+	countedDir = dir;
+	countedFilter = link->getSelectorFilter();
+	countText.clear();
+	if (snapshot->contains(dir)) {
+		stringstream count;
+		count << snapshot->countFiles(dir, FileFilter(countedFilter));
+		countText = " (" + gmenu2x->tr.translate(
+				"$1 files", count.str().c_str(), NULL) + ")";
+	}
+	return countText;
 }
 
 void Menu::setLinkIndex(int i) {
@@ -654,7 +757,9 @@ void Menu::openPackagesFromDir(std::string path)
 	DEBUG("Opening packages from directory: %s\n", path.c_str());
 	readPackages(path);
 #ifdef ENABLE_INOTIFY
-	monitors.push_back(new Monitor(path.c_str()));
+	Monitor *&monitor = monitors[path];
+	if (!monitor)
+		monitor = new Monitor(path.c_str());
 #endif
 }
 
@@ -671,7 +776,6 @@ void Menu::openPackage(std::string path, bool order)
 	}
 
 	for (;;) {
-		unsigned int i;
 		bool has_metadata = false;
 		const char *name;
 		LinkApp *link;
@@ -704,15 +808,19 @@ void Menu::openPackage(std::string path, bool order)
 		  break;
 
 		link = new LinkApp(gmenu2x, path.c_str(), opk, name);
-		link->setSize(gmenu2x->skinConfInt["linkWidth"], gmenu2x->skinConfInt["linkHeight"]);
-
-		addSection(link->getCategory());
-		for (i = 0; i < sections.size(); i++) {
-			if (sections[i] == link->getCategory()) {
-				links[i].push_back(link);
-				break;
-			}
+		link->setSize(gmenu2x->skinConf.linkWidth, gmenu2x->skinConf.linkHeight);
+
+		int i = sectionNamed(link->getCategory());
+		if (i < 0 && addSection(link->getCategory()))
+			i = sections.size() - 1;
+		if (i < 0) {
+			ERROR("Unable to add section for package %s\n", path.c_str());
+			delete link;
+			continue;
 		}
+
+		links[i].push_back(link);
+		packageLinks[path].push_back(link);
 	}
 
 	opk_close(opk);
@@ -757,42 +865,83 @@ void Menu::readPackages(std::string parentDir)
 	orderLinks();
 }
 
-#ifdef ENABLE_INOTIFY
+/* Erases the entry of the given package or directory, and the entries of
+ * the files somewhere below that directory, after passing each to "remove".
+ * Siblings such as "apps-old" sort between "apps" and "apps/", so the files
+ * below the directory are looked up as a range of their own. */
+template<typename T, typename F>
+static void erasePath(map<string, T> &entries, const string &path, F remove)
+{
+	auto it = entries.find(path);
+	if (it != entries.end()) {
+		remove(it->second);
+		entries.erase(it);
+	}
+
+	string prefix = path;
+	if (prefix.empty() || prefix[prefix.size() - 1] != '/')
+		prefix += '/';
+	it = entries.lower_bound(prefix);
+	while (it != entries.end()
+				&& !it->first.compare(0, prefix.size(), prefix)) {
+		remove(it->second);
+		it = entries.erase(it);
+	}
+}
+
+void Menu::unindexPackageLink(LinkApp *link)
+{
+	auto it = packageLinks.find(link->getOpkFile());
+	if (it == packageLinks.end())
+		return;
+
+	vector<LinkApp *> &apps = it->second;
+	apps.erase(remove(apps.begin(), apps.end(), link), apps.end());
+	if (apps.empty())
+		packageLinks.erase(it);
+}
+
 /* Remove all links that correspond to the given path.
  * If "path" is a directory, it will remove all links that
  * correspond to an OPK present in the directory. */
 void Menu::removePackageLink(std::string path)
 {
-	for (vector< vector<Link*> >::iterator section = links.begin();
-				section < links.end(); section++) {
-		for (vector<Link*>::iterator link = section->begin();
-					link < section->end(); link++) {
-			LinkApp *app = dynamic_cast<LinkApp *> (*link);
-			if (!app || !app->isOpk() || app->getOpkFile().empty())
-				continue;
-
-			if (app->getOpkFile().compare(0, path.size(), path) == 0) {
-				DEBUG("Removing link corresponding to package %s\n",
-							app->getOpkFile().c_str());
-				section->erase(link);
-				if (section - links.begin() == iSection
-							&& iLink == (int) section->size())
-					setLinkIndex(iLink - 1);
-				link--;
+	erasePath(packageLinks, path, [this](vector<LinkApp *> &apps) {
+		for (LinkApp *app : apps) {
+			DEBUG("Removing link corresponding to package %s\n",
+						app->getOpkFile().c_str());
+
+			/* The link is normally in the section of its category, but
+			 * renaming a section or moving the link does not change the
+			 * category: then look for it in every section. */
+			int i = sectionNamed(app->getCategory());
+			vector<Link *>::iterator it;
+			if (i < 0 || (it = find(links[i].begin(), links[i].end(), app))
+						== links[i].end()) {
+				for (i = 0; i < (int) links.size(); i++) {
+					it = find(links[i].begin(), links[i].end(), app);
+					if (it != links[i].end())
+						break;
+				}
+			}
+			if (i < (int) links.size()) {
+				vector<Link *> &section = links[i];
+				section.erase(it);
+				if (i == iSection && iLink >= (int) section.size())
+					setLinkIndex(max(0, (int) section.size() - 1));
 			}
+			delete app;
+			linksGeneration++;
 		}
-	}
+	});
 
+#ifdef ENABLE_INOTIFY
 	/* Remove registered monitors */
-	for (vector<Monitor *>::iterator it = monitors.begin();
-				it < monitors.end(); it++) {
-		if ((*it)->getPath().compare(0, path.size(), path) == 0) {
-			delete (*it);
-			monitors.erase(it);
-		}
-	}
-}
+	erasePath(monitors, path, [](Monitor *monitor) {
+		delete monitor;
+	});
 #endif
+}
 #endif
 
 void Menu::readLinksOfSection(std::string path, std::vector<std::string> &linkfiles)
@@ -803,7 +952,8 @@ void Menu::readLinksOfSection(std::string path, std::vector<std::string> &linkfi
 	if ((dirp = opendir(path.c_str())) == NULL) return;
 
 	while ((dptr = readdir(dirp))) {
-		if (dptr->d_type != DT_REG) continue;
+		// Skip hidden files, such as the temporary files of FileWriter.
+		if (dptr->d_type != DT_REG || dptr->d_name[0] == '.') continue;
 		string filepath = path + "/" + dptr->d_name;
 		linkfiles.push_back(filepath);
 	}
@@ -811,26 +961,27 @@ void Menu::readLinksOfSection(std::string path, std::vector<std::string> &linkfi
 	closedir(dirp);
 }
 
-static bool compare_links(Link *a, Link *b)
-{
-	LinkApp *app1 = dynamic_cast<LinkApp *>(a);
-	LinkApp *app2 = dynamic_cast<LinkApp *>(b);
-	bool app1_is_opk = app1 && app1->isOpk(),
-		 app2_is_opk = app2 && app2->isOpk();
-
-	if (app1_is_opk && !app2_is_opk)
-			return false;
-	if (app2_is_opk && !app1_is_opk)
-			return true;
-	return a->getTitle().compare(b->getTitle()) <= 0;
-}
-
 void Menu::orderLinks()
 {
-	for (std::vector< std::vector<Link *> >::iterator section = links.begin();
-				section < links.end(); section++)
-		if (section->size() > 1)
-			std::sort(section->begin(), section->end(), compare_links);
+	/* Packages come after the links, and each group is sorted by title.
+	 * The sort key is built once per link. */
+	vector<pair<string, Link *>> keyed;
+	for (auto &section : links) {
+		if (section.size() < 2)
+			continue;
+
+		keyed.clear();
+		for (Link *link : section) {
+			char group = link->getType() == Link::Type::OPK ? '1' : '0';
+			keyed.emplace_back(group + collationKey(link->getTitle()), link);
+		}
+		std::stable_sort(keyed.begin(), keyed.end(),
+			[](const pair<string, Link *> &a, const pair<string, Link *> &b) {
+				return a.first < b.first;
+			});
+		for (size_t i = 0; i < keyed.size(); i++)
+			section[i] = keyed[i].second;
+	}
 }
 
 void Menu::readLinks() {
@@ -852,10 +1003,10 @@ void Menu::readLinks() {
 		readLinksOfSection(GMenu2X::getHome() + "/sections/"
 		  + sections[correct], linkfiles);
 
-		sort(linkfiles.begin(), linkfiles.end(),case_less());
+		collationSort(linkfiles);
 		for (uint x=0; x<linkfiles.size(); x++) {
 			LinkApp *link = new LinkApp(gmenu2x, linkfiles[x].c_str());
-			link->setSize(gmenu2x->skinConfInt["linkWidth"], gmenu2x->skinConfInt["linkHeight"]);
+			link->setSize(gmenu2x->skinConf.linkWidth, gmenu2x->skinConf.linkHeight);
 			if (link->targetExists())
 				links[i].push_back(link);
 			else
@@ -865,5 +1016,7 @@ void Menu::readLinks() {
 }
 
 void Menu::renameSection(int index, const string &name) {
+	sectionIndex.erase(sections[index]);
 	sections[index] = name;
+	sectionIndex[name] = index;
 }
@@ -25,14 +25,17 @@
 #include "layer.h"
 #include "link.h"
 
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class GMenu2X;
 class IconButton;
 class LinkApp;
 class Monitor;
+struct MediaSnapshot;
 
 
 /**
@@ -51,6 +54,9 @@ private:
 		void step();
 	private:
 		int curr;
+		// Where the animation was when it was last adjusted, and when.
+		int from;
+		long tickStart;
 	};
 
 	GMenu2X *gmenu2x;
@@ -60,11 +66,23 @@ private:
 	uint iFirstDispRow;
 	std::vector<std::string> sections;
 	std::vector< std::vector<Link*> > links;
+	// Incremented whenever links are taken out of the menu.
+	unsigned int linksGeneration;
+
+	// Maps a section name to its index in "sections" and "links".
+	std::unordered_map<std::string, uint> sectionIndex;
+	void rebuildSectionIndex();
 
 	uint linkColumns, linkRows;
 
 	Animation sectionAnimation;
 
+	// The file count shown for the selected link, and what it was
+	// counted from.
+	std::shared_ptr<const MediaSnapshot> countedIn;
+	std::string countedDir, countedFilter, countText;
+	const std::string &fileCountOf(LinkApp *link);
+
 	/**
 	 * Determine which section headers are visible.
 	 * The output values are relative to the middle section at 0.
@@ -82,8 +100,14 @@ private:
 #ifdef HAVE_LIBOPK
 	// Load all the .opk packages of the given directory
 	void readPackages(std::string parentDir);
+
+	// Links created from each OPK, keyed by the path of the package.
+	// The map is ordered, so all the packages below a directory form
+	// a contiguous range that can be found with a single lookup.
+	std::map<std::string, std::vector<LinkApp *> > packageLinks;
+	void unindexPackageLink(LinkApp *link);
 #ifdef ENABLE_INOTIFY
-	std::vector<Monitor *> monitors;
+	std::map<std::string, Monitor *> monitors;
 #endif
 #endif
 
@@ -104,9 +128,7 @@ public:
 #ifdef HAVE_LIBOPK
 	void openPackage(std::string path, bool order = true);
 	void openPackagesFromDir(std::string path);
-#ifdef ENABLE_INOTIFY
 	void removePackageLink(std::string path);
-#endif
 #endif
 
 	int selSectionIndex();
@@ -129,6 +151,7 @@ public:
 	virtual void paint(Surface &s);
 	virtual bool handleButtonPress(InputManager::Button button);
 	virtual bool handleTouchscreen(Touchscreen &ts);
+	virtual const char *getName() { return "Menu"; }
 
 	bool linkChangeSection(uint linkIndex, uint oldSectionIndex, uint newSectionIndex);
 
@@ -138,6 +161,26 @@ public:
 	void setLinkIndex(int i);
 
 	const std::vector<std::string> &getSections() { return sections; }
+
+	/** Returns the folders that the links browse for files to open. */
+	std::vector<std::string> getSelectorDirs();
+	/** Returns all the links, section after section. */
+	std::vector<Link *> getLinks();
+	/**
+	 * Changes whenever links are removed from the menu, after which the
+	 * pointers returned by getLinks() may no longer be valid.
+	 */
+	unsigned int getLinksGeneration() { return linksGeneration; }
+	/**
+	 * Selects the given link and its section. Returns false if the link
+	 * is no longer in the menu.
+	 */
+	bool selectLink(Link *link);
+	/**
+	 * Returns the index of the section with the given name,
+	 * or -1 if there is no such section.
+	 */
+	int sectionNamed(const std::string &name);
 	void renameSection(int index, const std::string &name);
 };
 
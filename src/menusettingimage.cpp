@@ -40,9 +40,9 @@ void MenuSettingImage::edit() {
 }
 
 void MenuSettingImage::setValue(const string &value) {
-	string skinpath(gmenu2x->sc.getSkinPath(gmenu2x->confStr["skin"]));
+	string skinpath(gmenu2x->sc.getSkinPath(gmenu2x->conf.skin));
 	bool inSkinDir = value.substr(0, skinpath.length()) == skinpath;
-	if (!inSkinDir && gmenu2x->confStr["skin"] != "Default") {
+	if (!inSkinDir && gmenu2x->conf.skin != "Default") {
 		skinpath = gmenu2x->sc.getSkinPath("Default");
 		inSkinDir = value.substr(0, skinpath.length()) == skinpath;
 	}
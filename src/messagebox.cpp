@@ -20,6 +20,7 @@
 
 #include "messagebox.h"
 #include "gmenu2x.h"
+#include "latencytrace.h"
 #include "surface.h"
 
 #include <SDL_gfxPrimitives.h>
@@ -60,6 +61,8 @@ void MessageBox::setButton(InputManager::Button button, const string &label) {
 }
 
 int MessageBox::exec() {
+	LatencyTrace::Scope scope("MessageBox");
+
 	Surface bg(gmenu2x->s);
 	//Darken background
 	bg.box(0, 0, gmenu2x->resX, gmenu2x->resY, 0,0,0,200);
@@ -100,9 +103,11 @@ int MessageBox::exec() {
 	int result = -1;
 	while (result < 0) {
 		InputManager::Button button;
-		if (gmenu2x->input.pollButton(&button)
-				&& !buttons[button].empty()) {
-			result = button;
+		if (gmenu2x->input.pollButton(&button)) {
+			if (!buttons[button].empty())
+				result = button;
+			else // ignored: there is no frame to wait for
+				LatencyTrace::getInstance().discard();
 		}
 
 		usleep(LOOP_DELAY);
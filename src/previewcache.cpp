@@ -0,0 +1,155 @@
+#include "previewcache.h"
+
+#include "debug.h"
+#include "surface.h"
+#include "utilities.h"
+
+using namespace std;
+
+PreviewCache::PreviewCache(Loader loader)
+	: loader(loader)
+	, quitting(false)
+{
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&queued, NULL);
+	started = !pthread_create(&thread, NULL, threadMain, this);
+	if (!started)
+		ERROR("Unable to create preview loader thread\n");
+}
+
+PreviewCache::~PreviewCache()
+{
+	pthread_mutex_lock(&mutex);
+	quitting = true;
+	pthread_cond_signal(&queued);
+	pthread_mutex_unlock(&mutex);
+
+	if (started)
+		pthread_join(thread, NULL);
+
+	for (auto &it : loaded)
+		delete it.second;
+	pthread_cond_destroy(&queued);
+	pthread_mutex_destroy(&mutex);
+}
+
+void PreviewCache::request(const vector<string> &paths)
+{
+	if (paths == requested)
+		return;
+	requested = paths;
+
+	vector<Surface *> dropped;
+
+	pthread_mutex_lock(&mutex);
+	wanted.clear();
+	wanted.insert(paths.begin(), paths.end());
+	first = paths.empty() ? "" : paths.front();
+
+	for (auto it = loaded.begin(); it != loaded.end(); ) {
+		if (wanted.count(it->first)) {
+			++it;
+		} else {
+			dropped.push_back(it->second);
+			it = loaded.erase(it);
+		}
+	}
+
+	queue.clear();
+	for (auto &path : paths) {
+		if (!loaded.count(path) && !failed.count(path) && path != loading)
+			queue.push_back(path);
+	}
+	if (!queue.empty())
+		pthread_cond_signal(&queued);
+	pthread_mutex_unlock(&mutex);
+
+	for (Surface *surface : dropped)
+		delete surface;
+}
+
+Surface *PreviewCache::get(const string &path)
+{
+	pthread_mutex_lock(&mutex);
+	auto it = loaded.find(path);
+	Surface *surface = it == loaded.end() ? NULL : it->second;
+	pthread_mutex_unlock(&mutex);
+	return surface;
+}
+
+Surface *PreviewCache::take(const string &path)
+{
+	pthread_mutex_lock(&mutex);
+	auto it = loaded.find(path);
+	Surface *surface = NULL;
+	if (it != loaded.end()) {
+		surface = it->second;
+		loaded.erase(it);
+	}
+	pthread_mutex_unlock(&mutex);
+	return surface;
+}
+
+bool PreviewCache::hasFailed(const string &path)
+{
+	pthread_mutex_lock(&mutex);
+	bool ret = failed.count(path);
+	pthread_mutex_unlock(&mutex);
+	return ret;
+}
+
+void PreviewCache::clear()
+{
+	request(vector<string>());
+
+	pthread_mutex_lock(&mutex);
+	failed.clear();
+	pthread_mutex_unlock(&mutex);
+}
+
+void *PreviewCache::threadMain(void *p)
+{
+	static_cast<PreviewCache *>(p)->run();
+	return NULL;
+}
+
+void PreviewCache::run()
+{
+	pthread_mutex_lock(&mutex);
+	while (!quitting) {
+		if (queue.empty()) {
+			pthread_cond_wait(&queued, &mutex);
+			continue;
+		}
+
+		string path = queue.front();
+		queue.pop_front();
+		loading = path;
+		pthread_mutex_unlock(&mutex);
+
+		// Screenshots are blended over the list: no alpha channel.
+		Surface *surface = loader ? loader(path)
+					: Surface::loadImage(path, "", false);
+
+		pthread_mutex_lock(&mutex);
+		loading.clear();
+		const bool isWanted = wanted.count(path);
+		bool keep = surface && isWanted && !loaded.count(path);
+		if (keep)
+			loaded[path] = surface;
+		else if (!surface && isWanted)
+			failed.insert(path);
+		/* Also when the image failed to load: the owner then moves on
+		 * to the next one, which is not the most wanted. */
+		bool notify = (keep || (!surface && isWanted)) && path == first;
+		pthread_mutex_unlock(&mutex);
+
+		if (!keep)
+			delete surface;
+		if (notify)
+			inject_user_event();
+
+		pthread_mutex_lock(&mutex);
+	}
+	pthread_mutex_unlock(&mutex);
+}
@@ -0,0 +1,85 @@
+#ifndef PREVIEWCACHE_H
+#define PREVIEWCACHE_H
+
+#include <deque>
+#include <functional>
+#include <pthread.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Surface;
+
+/**
+ * Loads preview images on a background thread, so that moving the cursor
+ * through a list never waits for a PNG to be decoded.
+ *
+ * The owner tells which images it wants, most wanted first: typically the
+ * one of the selected entry followed by those of its neighbours. Images
+ * that are no longer wanted are dropped, which bounds the memory used to
+ * the size of that window. A repaint event is sent when the most wanted
+ * image has been loaded, or could not be. An image that could not be
+ * loaded is not tried again.
+ */
+class PreviewCache {
+public:
+	/** Loads the image at a path; called on the background thread. */
+	typedef std::function<Surface *(const std::string &path)> Loader;
+
+	/**
+	 * Without a loader, images are loaded at full size and without alpha
+	 * channel, to be blended over the screen.
+	 */
+	PreviewCache(Loader loader = nullptr);
+	~PreviewCache();
+
+	/**
+	 * Replaces the list of wanted images. Loaded images that are not in
+	 * the list are freed; the others are queued for loading, in order.
+	 */
+	void request(const std::vector<std::string> &paths);
+
+	/**
+	 * Returns the image at "path" if it has been loaded already, NULL
+	 * otherwise. The surface stays valid until the next request().
+	 */
+	Surface *get(const std::string &path);
+
+	/**
+	 * Like get(), but the caller becomes the owner of the image, which is
+	 * removed from the cache.
+	 */
+	Surface *take(const std::string &path);
+
+	/**
+	 * Returns true if the image at "path" was wanted but could not be
+	 * loaded. Such an image is left out of the next requests.
+	 */
+	bool hasFailed(const std::string &path);
+
+	/**
+	 * Frees all the images and cancels the pending loads. The images that
+	 * could not be loaded are tried again when requested.
+	 */
+	void clear();
+
+private:
+	static void *threadMain(void *p);
+	void run();
+
+	Loader loader;
+
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t queued;
+	bool started, quitting;
+
+	std::vector<std::string> requested;
+	std::deque<std::string> queue;
+	std::string first, loading;
+	std::unordered_set<std::string> wanted, failed;
+	std::unordered_map<std::string, Surface *> loaded;
+};
+
+#endif
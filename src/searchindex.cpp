@@ -0,0 +1,203 @@
+#include "searchindex.h"
+
+#include "utilities.h"
+
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+/* Below this many entries, comparing the query with every entry is about
+ * as fast as the lookup, and the tables are not worth their memory. */
+static const unsigned int MIN_INDEXED_ENTRIES = 2048;
+
+/* Characters are folded to 6 bits: letters and digits get a value of
+ * their own, the other bytes share the rest. Folding only causes extra
+ * candidates, which are weeded out by the comparison. */
+static const unsigned int NUM_TRIGRAMS = 1 << 18;
+
+static inline uint32_t fold(unsigned char c)
+{
+	if (c >= 'a' && c <= 'z')
+		return c - 'a' + 1;
+	if (c >= '0' && c <= '9')
+		return c - '0' + 27;
+	return 37 + c % 27;
+}
+
+/* Query words never contain a space or a newline, so neither do the
+ * trigrams worth indexing. */
+static inline bool isIndexed(const char *p)
+{
+	return p[0] != ' ' && p[0] != '\n' && p[1] != ' ' && p[1] != '\n'
+		&& p[2] != ' ' && p[2] != '\n';
+}
+
+static inline uint32_t trigram(const char *p)
+{
+	return fold(p[0]) << 12 | fold(p[1]) << 6 | fold(p[2]);
+}
+
+static string lower(const string &str)
+{
+	string ret(str);
+	for (auto &c : ret)
+		c = tolower((unsigned char) c);
+	return ret;
+}
+
+SearchIndex::SearchIndex()
+{
+}
+
+unsigned int SearchIndex::add(const string &title, const string &details)
+{
+	string key = lower(title);
+	titleLengths.push_back(min<size_t>(key.size(), UINT16_MAX));
+	if (!details.empty()) {
+		key += '\n';
+		key += lower(details);
+	}
+	keys.push_back(key);
+	return keys.size() - 1;
+}
+
+void SearchIndex::build()
+{
+	offsets.clear();
+	postings.clear();
+	if (keys.size() < MIN_INDEXED_ENTRIES)
+		return;
+
+	/* A counting sort: count the entries per trigram, then fill in each
+	 * list. An entry that repeats a trigram is listed once. */
+	vector<uint32_t> lastEntry(NUM_TRIGRAMS, UINT32_MAX);
+	offsets.assign(NUM_TRIGRAMS + 1, 0);
+	for (uint32_t i = 0; i < keys.size(); i++) {
+		const string &key = keys[i];
+		for (size_t j = 0; j + 2 < key.size(); j++) {
+			if (!isIndexed(&key[j]))
+				continue;
+			const uint32_t t = trigram(&key[j]);
+			if (lastEntry[t] != i) {
+				lastEntry[t] = i;
+				offsets[t + 1]++;
+			}
+		}
+	}
+	for (uint32_t t = 0; t < NUM_TRIGRAMS; t++)
+		offsets[t + 1] += offsets[t];
+
+	postings.resize(offsets[NUM_TRIGRAMS]);
+	vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	lastEntry.assign(NUM_TRIGRAMS, UINT32_MAX);
+	for (uint32_t i = 0; i < keys.size(); i++) {
+		const string &key = keys[i];
+		for (size_t j = 0; j + 2 < key.size(); j++) {
+			if (!isIndexed(&key[j]))
+				continue;
+			const uint32_t t = trigram(&key[j]);
+			if (lastEntry[t] != i) {
+				lastEntry[t] = i;
+				postings[fill[t]++] = i;
+			}
+		}
+	}
+
+	lastQuery.clear();
+	lastMatches.clear();
+}
+
+vector<uint32_t> SearchIndex::candidates(const vector<string> &words)
+{
+	vector<uint32_t> ret;
+
+	uint32_t first = 0, last = 0;
+	bool found = false;
+	if (!postings.empty()) {
+		for (auto &word : words) {
+			for (size_t j = 0; j + 2 < word.size(); j++) {
+				const uint32_t t = trigram(&word[j]);
+				if (!found || offsets[t + 1] - offsets[t] < last - first) {
+					first = offsets[t];
+					last = offsets[t + 1];
+					found = true;
+				}
+			}
+		}
+	}
+
+	if (found) {
+		ret.assign(postings.begin() + first, postings.begin() + last);
+	} else {
+		// Only words of one or two characters: try every entry.
+		ret.resize(keys.size());
+		for (uint32_t i = 0; i < keys.size(); i++)
+			ret[i] = i;
+	}
+	return ret;
+}
+
+unsigned int SearchIndex::rank(uint32_t entry, const string &word) const
+{
+	const string &key = keys[entry];
+	const size_t pos = key.find(word);
+	if (pos == 0)
+		return 0;
+	if (pos + word.size() > titleLengths[entry])
+		return 3;
+	return isalnum((unsigned char) key[pos - 1]) ? 2 : 1;
+}
+
+vector<unsigned int> SearchIndex::search(const string &query,
+		unsigned int maxResults)
+{
+	const string lowerQuery = lower(query);
+	vector<string> words;
+	split(words, lowerQuery, " ");
+	words.erase(remove(words.begin(), words.end(), ""), words.end());
+	if (words.empty()) {
+		lastQuery.clear();
+		lastMatches.clear();
+		return vector<unsigned int>();
+	}
+
+	/* Every word of the previous query is still in this one, possibly
+	 * longer: the matches can only be fewer. */
+	vector<uint32_t> entries;
+	if (!lastQuery.empty() && !lowerQuery.compare(0, lastQuery.size(), lastQuery))
+		entries.swap(lastMatches);
+	else
+		entries = candidates(words);
+
+	auto matches = [this, &words](uint32_t entry) {
+		const string &key = keys[entry];
+		for (auto &word : words) {
+			if (key.find(word) == string::npos)
+				return false;
+		}
+		return true;
+	};
+	entries.erase(remove_if(entries.begin(), entries.end(),
+				[&matches](uint32_t entry) { return !matches(entry); }),
+			entries.end());
+
+	/* Rank, then title length, then the order of the entries, packed in
+	 * one number so that ordering the matches is cheap. */
+	vector<uint64_t> order;
+	order.reserve(entries.size());
+	for (uint32_t entry : entries) {
+		order.push_back((uint64_t) rank(entry, words[0]) << 48
+				| (uint64_t) titleLengths[entry] << 32 | entry);
+	}
+	const size_t count = min<size_t>(order.size(), maxResults);
+	partial_sort(order.begin(), order.begin() + count, order.end());
+
+	vector<unsigned int> results(count);
+	for (size_t i = 0; i < count; i++)
+		results[i] = (uint32_t) order[i];
+
+	lastQuery = lowerQuery;
+	lastMatches.swap(entries);
+	return results;
+}
@@ -0,0 +1,60 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Substring search over a fixed set of titles, fast enough to run again on
+ * every key press with tens of thousands of entries.
+ *
+ * A query is split into words at spaces, and an entry matches if every word
+ * occurs in it, without regard to case. Entries are indexed by trigrams
+ * (runs of three characters): only the entries that contain the rarest
+ * trigram of the query are compared with it. A query that extends the
+ * previous one only narrows down the previous matches.
+ */
+class SearchIndex {
+public:
+	SearchIndex();
+
+	/**
+	 * Adds an entry and returns its number, counting from 0. The words
+	 * of "details" are found too, but rank below those of the title.
+	 */
+	unsigned int add(const std::string &title,
+			const std::string &details = "");
+	/** Indexes the entries; call once, after adding all of them. */
+	void build();
+
+	unsigned int size() const { return keys.size(); }
+
+	/**
+	 * Returns the numbers of the entries that match "query", best first:
+	 * matches at the start of the title, then at the start of a word of
+	 * the title, then anywhere in the title and last in the details;
+	 * shorter titles first within each group. At most "maxResults"
+	 * numbers are returned.
+	 */
+	std::vector<unsigned int> search(const std::string &query,
+			unsigned int maxResults);
+
+private:
+	std::vector<uint32_t> candidates(const std::vector<std::string> &words);
+	unsigned int rank(uint32_t entry, const std::string &word) const;
+
+	/* Lower-cased title, then a newline and the lower-cased details. */
+	std::vector<std::string> keys;
+	std::vector<uint16_t> titleLengths;
+
+	/* The entries containing trigram "t" are postings[offsets[t]] up to
+	 * postings[offsets[t + 1]], in order. Empty for small indexes. */
+	std::vector<uint32_t> offsets, postings;
+
+	/* The previous query and all of its matches, in order. */
+	std::string lastQuery;
+	std::vector<uint32_t> lastMatches;
+};
+
+#endif
@@ -0,0 +1,406 @@
+#include "searchlayer.h"
+
+#include "debug.h"
+#include "filefilter.h"
+#include "gmenu2x.h"
+#include "linkapp.h"
+#include "mediaindex.h"
+#include "menu.h"
+#include "surface.h"
+#include "touchscreen.h"
+
+#include <algorithm>
+
+using namespace std;
+
+#define KEY_WIDTH 20
+#define KEY_HEIGHT 20
+
+static const char *KEYS[] = {
+	"abcdefghijklm",
+	"nopqrstuvwxyz",
+	"0123456789.-'",
+};
+static const int KEY_ROWS = 3;
+static const int KEY_COLUMNS = 13;
+
+/* Per kind of result: the list only has room for a few pages anyway. */
+static const unsigned int MAX_RESULTS = 100;
+
+struct SearchLayer::FileIndex {
+	struct Entry {
+		const IndexedDir *dir;
+		unsigned int file, owner;
+	};
+
+	shared_ptr<const MediaSnapshot> snapshot;
+	string signature;
+	vector<Entry> entries;
+	SearchIndex index;
+};
+
+shared_ptr<SearchLayer::FileIndex> SearchLayer::lastFiles;
+
+static string withoutExtension(const string &file)
+{
+	const string::size_type pos = file.rfind('.');
+	return pos == string::npos || pos == 0 ? file : file.substr(0, pos);
+}
+
+SearchLayer::SearchLayer(GMenu2X &gmenu2x, Menu &menu)
+	: gmenu2x(gmenu2x)
+	, menu(menu)
+	, list(&gmenu2x)
+	, selRow(0)
+	, selCol(0)
+	, inResults(false)
+{
+	noMatchesLabel = gmenu2x.tr.intern("No matches");
+
+	links = menu.getLinks();
+	linksGeneration = menu.getLinksGeneration();
+	for (Link *link : links)
+		linkIndex.add(link->getTitle(), link->getDescription());
+	linkIndex.build();
+	indexFiles();
+
+	const int fontHeight = gmenu2x.font->getHeight();
+	queryBox = {
+		4, 4,
+		static_cast<Uint16>(gmenu2x.resX - 8),
+		static_cast<Uint16>(fontHeight + 4)
+	};
+	kbLeft = (gmenu2x.resX - KEY_COLUMNS * KEY_WIDTH) / 2;
+	kbTop = gmenu2x.resY - KEY_ROWS * KEY_HEIGHT - 4;
+
+	const int listTop = queryBox.y + queryBox.h + 4;
+	list.setArea((SDL_Rect) {
+		0, static_cast<Sint16>(listTop),
+		static_cast<Uint16>(gmenu2x.resX - 9),
+		static_cast<Uint16>(kbTop - 4 - listTop)
+	}, fontHeight);
+	list.setLabels([this](unsigned int i) {
+		return labelOf(results[i]);
+	});
+	list.setCursor(false);
+}
+
+SearchLayer::~SearchLayer()
+{
+}
+
+/* The links removed from the menu, e.g. when a card is taken out, have been
+ * deleted: the results can no longer be shown, so close the search. */
+bool SearchLayer::linksRemoved()
+{
+	if (menu.getLinksGeneration() == linksGeneration)
+		return false;
+	dismiss();
+	return true;
+}
+
+void SearchLayer::indexFiles()
+{
+	for (Link *link : links) {
+		if (link->isApp()
+				&& !static_cast<LinkApp *>(link)->getSelectorDir().empty())
+			owners.push_back(static_cast<LinkApp *>(link));
+	}
+	stable_sort(owners.begin(), owners.end(), [](LinkApp *a, LinkApp *b) {
+		return a->getSelectorDir().size() > b->getSelectorDir().size();
+	});
+
+	vector<string> dirs;
+	vector<FileFilter> filters;
+	string signature;
+	for (LinkApp *app : owners) {
+		string dir = app->getSelectorDir();
+		if (dir[dir.length() - 1] != '/')
+			dir += '/';
+		dirs.push_back(dir);
+		filters.push_back(FileFilter(app->getSelectorFilter()));
+		signature += dir + '\n' + app->getSelectorFilter() + '\n';
+	}
+
+	shared_ptr<const MediaSnapshot> snapshot =
+			MediaIndex::getInstance().getSnapshot();
+	if (lastFiles && lastFiles->snapshot == snapshot
+			&& lastFiles->signature == signature) {
+		files = lastFiles;
+		return;
+	}
+
+	files = make_shared<FileIndex>();
+	files->snapshot = snapshot;
+	files->signature = signature;
+
+	vector<unsigned int> candidates;
+	for (auto &dir : snapshot->dirs) {
+		candidates.clear();
+		for (unsigned int i = 0; i < dirs.size(); i++) {
+			if (!dir->path.compare(0, dirs[i].size(), dirs[i]))
+				candidates.push_back(i);
+		}
+		if (candidates.empty())
+			continue;
+
+		for (unsigned int j = 0; j < dir->files.size(); j++) {
+			const string &name = dir->files[j];
+			if (name[0] == '.')
+				continue;
+			for (unsigned int owner : candidates) {
+				if (filters[owner].matches(name)) {
+					FileIndex::Entry entry = { dir.get(), j, owner };
+					files->entries.push_back(entry);
+					files->index.add(withoutExtension(name));
+					break;
+				}
+			}
+		}
+	}
+	files->index.build();
+	lastFiles = files;
+
+	DEBUG("Indexed %u files for searching\n", files->index.size());
+}
+
+void SearchLayer::update()
+{
+	results.clear();
+	for (unsigned int i : linkIndex.search(query, MAX_RESULTS)) {
+		Result result = { links[i], 0 };
+		results.push_back(result);
+	}
+	for (unsigned int i : files->index.search(query, MAX_RESULTS)) {
+		Result result = { nullptr, i };
+		results.push_back(result);
+	}
+
+	list.invalidate();
+	list.setSize(results.size());
+	list.setSelected(0);
+	if (results.empty())
+		focusKeyboard();
+}
+
+string SearchLayer::labelOf(const Result &result)
+{
+	if (result.link)
+		return result.link->getTitle();
+
+	const FileIndex::Entry &entry = files->entries[result.file];
+	return withoutExtension(entry.dir->files[entry.file])
+			+ " (" + owners[entry.owner]->getTitle() + ")";
+}
+
+void SearchLayer::type(const string &text)
+{
+	query += text;
+	update();
+}
+
+void SearchLayer::backspace()
+{
+	if (query.empty())
+		return;
+
+	// Remove a whole UTF-8 sequence.
+	string::size_type pos = query.length() - 1;
+	while (pos > 0 && (query[pos] & 0xC0) == 0x80)
+		pos--;
+	query.erase(pos);
+	update();
+}
+
+void SearchLayer::launch(unsigned int i)
+{
+	if (i >= results.size())
+		return;
+	const Result result = results[i];
+	dismiss();
+
+	if (result.link) {
+		if (menu.selectLink(result.link))
+			result.link->run();
+	} else {
+		const FileIndex::Entry &entry = files->entries[result.file];
+		LinkApp *app = owners[entry.owner];
+		if (menu.selectLink(app))
+			gmenu2x.queueLaunch(app,
+					entry.dir->path + entry.dir->files[entry.file]);
+	}
+}
+
+void SearchLayer::focusResults()
+{
+	if (results.empty())
+		return;
+
+	// Coming from the keyboard below, start at the bottom of the page.
+	inResults = true;
+	list.setCursor(true);
+	list.setSelected(min<unsigned int>(
+			list.getFirst() + list.getRowsPerPage(), results.size()) - 1);
+}
+
+void SearchLayer::focusKeyboard()
+{
+	if (!inResults)
+		return;
+	inResults = false;
+	list.setCursor(false);
+	selRow = 0;
+}
+
+SDL_Rect SearchLayer::keyRect(int row, int col)
+{
+	return (SDL_Rect) {
+		static_cast<Sint16>(kbLeft + col * KEY_WIDTH),
+		static_cast<Sint16>(kbTop + row * KEY_HEIGHT),
+		KEY_WIDTH - 1,
+		KEY_HEIGHT - 2
+	};
+}
+
+void SearchLayer::paint(Surface &s)
+{
+	if (linksRemoved())
+		return;
+
+	Font *font = gmenu2x.font;
+	RGBAColor selectionColor = gmenu2x.skinConfColors[COLOR_SELECTION_BG];
+
+	s.box(0, 0, gmenu2x.resX, gmenu2x.resY,
+			gmenu2x.skinConfColors[COLOR_MESSAGE_BOX_BG]);
+
+	// Query, with the caret after it.
+	s.rectangle(queryBox, selectionColor);
+	s.write(font, query, queryBox.x + 4, queryBox.y + queryBox.h - 2,
+			Font::HAlignLeft, Font::VAlignBottom);
+	s.box(queryBox.x + 6 + font->getTextWidth(query), queryBox.y + 3,
+			8, queryBox.h - 6, selectionColor);
+
+	// Results.
+	list.paint(&s);
+	if (results.empty() && !query.empty())
+		s.write(font, gmenu2x.tr[noMatchesLabel], gmenu2x.resX / 2,
+				(queryBox.y + queryBox.h + kbTop) / 2,
+				Font::HAlignCenter, Font::VAlignMiddle);
+
+	// Keyboard.
+	if (!inResults)
+		s.box(keyRect(selRow, selCol), selectionColor);
+	for (int row = 0; row < KEY_ROWS; row++) {
+		for (int col = 0; col < KEY_COLUMNS; col++) {
+			SDL_Rect re = keyRect(row, col);
+			s.rectangle(re, selectionColor);
+			s.write(font, string(1, KEYS[row][col]),
+					re.x + KEY_WIDTH / 2, re.y + KEY_HEIGHT / 2,
+					Font::HAlignCenter, Font::VAlignMiddle);
+		}
+	}
+}
+
+bool SearchLayer::handleButtonPress(InputManager::Button button)
+{
+	if (linksRemoved())
+		return true;
+
+	if (inResults) {
+		switch (button) {
+			case InputManager::UP:
+				list.up();
+				break;
+			case InputManager::DOWN:
+				if (list.getSelected() + 1 >= results.size())
+					focusKeyboard();
+				else
+					list.down();
+				break;
+			case InputManager::ALTLEFT:
+				list.pageUp();
+				break;
+			case InputManager::ALTRIGHT:
+				list.pageDown();
+				break;
+			case InputManager::LEFT:
+			case InputManager::RIGHT:
+			case InputManager::CANCEL:
+				focusKeyboard();
+				break;
+			case InputManager::ACCEPT:
+			case InputManager::SETTINGS:
+				launch(list.getSelected());
+				break;
+			case InputManager::MENU:
+				dismiss();
+				break;
+			default:
+				break;
+		}
+		return true;
+	}
+
+	switch (button) {
+		case InputManager::UP:
+			if (selRow == 0 && !results.empty())
+				focusResults();
+			else
+				selRow = (selRow + KEY_ROWS - 1) % KEY_ROWS;
+			break;
+		case InputManager::DOWN:
+			selRow = (selRow + 1) % KEY_ROWS;
+			break;
+		case InputManager::LEFT:
+			selCol = (selCol + KEY_COLUMNS - 1) % KEY_COLUMNS;
+			break;
+		case InputManager::RIGHT:
+			selCol = (selCol + 1) % KEY_COLUMNS;
+			break;
+		case InputManager::ACCEPT:
+			type(string(1, KEYS[selRow][selCol]));
+			break;
+		case InputManager::ALTLEFT:
+			backspace();
+			break;
+		case InputManager::ALTRIGHT:
+			type(" ");
+			break;
+		case InputManager::SETTINGS:
+			launch(0);
+			break;
+		case InputManager::CANCEL:
+		case InputManager::MENU:
+			dismiss();
+			break;
+		default:
+			break;
+	}
+	return true;
+}
+
+bool SearchLayer::handleTouchscreen(Touchscreen &ts)
+{
+	if (!ts.released() || linksRemoved())
+		return true;
+
+	for (int row = 0; row < KEY_ROWS; row++) {
+		for (int col = 0; col < KEY_COLUMNS; col++) {
+			if (ts.inRect(keyRect(row, col))) {
+				focusKeyboard();
+				selRow = row;
+				selCol = col;
+				type(string(1, KEYS[row][col]));
+				ts.setHandled();
+				return true;
+			}
+		}
+	}
+
+	const int row = list.rowAt(ts.getX(), ts.getY());
+	if (row >= 0) {
+		launch(row);
+		ts.setHandled();
+	}
+	return true;
+}
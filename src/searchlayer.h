@@ -0,0 +1,80 @@
+#ifndef SEARCHLAYER_H
+#define SEARCHLAYER_H
+
+#include "layer.h"
+#include "listview.h"
+#include "searchindex.h"
+#include "translator.h"
+
+#include <SDL.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+class GMenu2X;
+class Link;
+class LinkApp;
+class Menu;
+
+/**
+ * Finds links and the files they can open as the user types: the results
+ * are searched again after every key, and launched with a press of A.
+ *
+ * Links are found by title and description, which for an OPK are its Name
+ * and Comment. Files come from the media index, below the folders that
+ * links browse; each file is opened with the link whose folder is closest
+ * to it and whose filter accepts it.
+ */
+class SearchLayer : public Layer {
+public:
+	SearchLayer(GMenu2X &gmenu2x, Menu &menu);
+	virtual ~SearchLayer();
+
+	// Layer implementation:
+	virtual void paint(Surface &s);
+	virtual bool handleButtonPress(InputManager::Button button);
+	virtual bool handleTouchscreen(Touchscreen &ts);
+	virtual const char *getName() { return "SearchLayer"; }
+
+private:
+	struct FileIndex;
+	struct Result {
+		Link *link; // NULL for a file
+		unsigned int file;
+	};
+
+	bool linksRemoved();
+	void indexFiles();
+	void update();
+	std::string labelOf(const Result &result);
+	void type(const std::string &text);
+	void backspace();
+	void launch(unsigned int i);
+	void focusResults();
+	void focusKeyboard();
+	SDL_Rect keyRect(int row, int col);
+
+	GMenu2X &gmenu2x;
+	Menu &menu;
+	ListView list;
+	Translator::Handle noMatchesLabel;
+
+	std::vector<Link *> links;
+	unsigned int linksGeneration;
+	SearchIndex linkIndex;
+
+	/* The links that open files, most specific folder first, and the files
+	 * they open. The files are indexed again only when the media index or
+	 * these links have changed since the previous search. */
+	std::vector<LinkApp *> owners;
+	std::shared_ptr<FileIndex> files;
+	static std::shared_ptr<FileIndex> lastFiles;
+
+	std::string query;
+	std::vector<Result> results;
+	SDL_Rect queryBox;
+	int kbLeft, kbTop, selRow, selCol;
+	bool inResults;
+};
+
+#endif
@@ -20,10 +20,15 @@
 
 #include "selector.h"
 
+#include "aliasindex.h"
+#include "collation.h"
+#include "dircache.h"
 #include "debug.h"
 #include "filelister.h"
 #include "gmenu2x.h"
+#include "latencytrace.h"
 #include "linkapp.h"
+#include "listview.h"
 #include "menu.h"
 #include "surface.h"
 #include "utilities.h"
@@ -36,46 +41,65 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
-#include <fstream>
 
 using namespace std;
 
+/* Number of entries above and below the cursor whose screenshots are
+ * loaded in advance. */
+static const int PREFETCH_DISTANCE = 3;
+
 Selector::Selector(GMenu2X *gmenu2x, LinkApp *link, const string &selectorDir) :
-	Dialog(gmenu2x)
+	Dialog(gmenu2x),
+	// Screenshots are blended over the list: no alpha channel.
+	screenshots([gmenu2x](const string &path) {
+		return Surface::loadThumbnail(path, gmenu2x->resX, gmenu2x->resY);
+	})
 {
 	this->link = link;
-	loadAliases();
+	if (!link->getAliasFile().empty())
+		aliases = AliasIndex::get(link->getAliasFile());
 	selRow = 0;
 	if (selectorDir.empty())
 		dir = link->getSelectorDir();
 	else
 		dir = selectorDir;
 	if (dir[dir.length()-1]!='/') dir += "/";
+	previewsListed = false;
+	loadingLabel = gmenu2x->tr.intern("Loading...");
 }
 
-int Selector::exec(int startSelection) {
-	bool close = false, result = true;
-	vector<string> screens, titles;
-
-	FileLister fl(dir, link->getSelectorBrowser());
-	fl.setFilter(link->getSelectorFilter());
-	fl.browse();
+/* Returns the position of "name" among the entries of "fl". */
+static uint findEntry(FileLister &fl, const string &name, bool isDir) {
+	const vector<string> &vec = isDir ? fl.getDirectories() : fl.getFiles();
+	vector<string>::const_iterator it =
+				lower_bound(vec.begin(), vec.end(), name, collation_less());
+	return (isDir ? 0 : fl.dirCount()) + (it - vec.begin());
+}
 
-	Surface bg(gmenu2x->bg);
-	drawTitleIcon(link->getIconPath(), true, &bg);
-	writeTitle(link->getTitle(), &bg);
-	writeSubTitle(link->getDescription(), &bg);
+void Selector::paintChrome(Surface *s) {
+	drawTitleIcon(link->getIconPath(), true, s);
+	writeTitle(link->getTitle(), s);
+	writeSubTitle(link->getDescription(), s);
 
 	if (link->getSelectorBrowser()) {
-		gmenu2x->drawButton(&bg, "start", gmenu2x->tr["Exit"],
-		gmenu2x->drawButton(&bg, "accept", gmenu2x->tr["Select a file"],
-		gmenu2x->drawButton(&bg, "cancel", gmenu2x->tr["Up one folder"],
-		gmenu2x->drawButton(&bg, "left", "", 5)-10)));
+		gmenu2x->drawButton(s, "start", gmenu2x->tr["Exit"],
+		gmenu2x->drawButton(s, "accept", gmenu2x->tr["Select a file"],
+		gmenu2x->drawButton(s, "cancel", gmenu2x->tr["Up one folder"],
+		gmenu2x->drawButton(s, "left", "", 5)-10)));
 	} else {
-		gmenu2x->drawButton(&bg, "start", gmenu2x->tr["Exit"],
-		gmenu2x->drawButton(&bg, "cancel", "",
-		gmenu2x->drawButton(&bg, "accept", gmenu2x->tr["Select a file"], 5)) - 10);
+		gmenu2x->drawButton(s, "start", gmenu2x->tr["Exit"],
+		gmenu2x->drawButton(s, "cancel", "",
+		gmenu2x->drawButton(s, "accept", gmenu2x->tr["Select a file"], 5)) - 10);
 	}
+}
+
+int Selector::exec(int startSelection) {
+	LatencyTrace::Scope scope("Selector");
+
+	bool close = false, result = true;
+
+	FileLister fl(dir, link->getSelectorBrowser());
+	fl.setFilter(link->getSelectorFilter());
 
 	unsigned int top, height;
 	tie(top, height) = gmenu2x->getContentArea();
@@ -83,96 +107,101 @@ int Selector::exec(int startSelection) {
 	int fontheight = gmenu2x->font->getHeight();
 	if (link->getSelectorBrowser())
 		fontheight = constrain(fontheight, 20, 40);
-	unsigned int nb_elements = height / fontheight;
-
-	bg.convertToDisplayFormat();
-
-	Uint32 selTick = SDL_GetTicks(), curTick;
-	uint i, firstElement = 0, iY;
-
-	prepare(&fl,&screens,&titles);
-	uint selected = constrain(startSelection,0,fl.size()-1);
 
-	//Add the folder icon manually to be sure to load it with alpha support since we are going to disable it for screenshots
 	if (gmenu2x->sc.skinRes("imgs/folder.png")==NULL)
 		gmenu2x->sc.addSkinRes("imgs/folder.png");
-	gmenu2x->sc.defaultAlpha = false;
+	Surface *folderIcon = gmenu2x->sc["imgs/folder.png"];
+
+	ListView list(gmenu2x);
+	list.setArea((SDL_Rect) {
+		0, static_cast<Sint16>(top), 311, static_cast<Uint16>(height)
+	}, fontheight);
+	list.setLabels([&](uint i) {
+		return fl.isDirectory(i) ? fl[i] : getFileInfo(fl[i]).title;
+	});
+	list.setIcons([&](uint i) {
+		return fl.isDirectory(i) ? folderIcon : nullptr;
+	});
+
+	prepare(&fl);
+	/* While the directory is read in the background, entries keep being
+	 * inserted: follow the start selection until the user moves, then
+	 * stay on the selected entry. */
+	bool followStart = true;
+
 	while (!close) {
-		bg.blit(gmenu2x->s,0,0);
+		string selName;
+		bool selIsDir = fl.isDirectory(list.getSelected());
+		if (!followStart && list.getSelected() < fl.size())
+			selName = fl[list.getSelected()];
+
+		const bool added = fl.update();
+		if (added || followStart) {
+			if (added)
+				list.invalidate();
+			list.setSize(fl.size());
+			if (followStart)
+				list.setSelected(fl.size() ? constrain(startSelection, 0, fl.size() - 1) : 0);
+			else if (!selName.empty())
+				list.setSelected(findEntry(fl, selName, selIsDir));
+		}
+		const uint selected = list.getSelected();
 
-		if (selected >= firstElement + nb_elements)
-			firstElement = selected - nb_elements + 1;
-		if (selected < firstElement)
-			firstElement = selected;
+		getChrome()->blit(gmenu2x->s,0,0);
 
 		//Screenshot
-		if (selected-fl.dirCount()<screens.size()
-				&& !screens[selected-fl.dirCount()].empty()) {
-			curTick = SDL_GetTicks();
-			Surface *screenshot = gmenu2x->sc[screens[selected-fl.dirCount()]];
-			if (screenshot)
-				screenshot->blitRight(
-						gmenu2x->s, 320, 0, 320, 240,
-						128u);
+		prefetchScreenshots(fl, selected);
+		if (fl.isFile(selected)) {
+			const string &screen = getFileInfo(fl[selected]).screen;
+			if (!screen.empty()) {
+				Surface *screenshot = screenshots.get(screen);
+				if (screenshot)
+					screenshot->blitRight(
+							gmenu2x->s, 320, 0, 320, 240,
+							128u);
+			}
 		}
 
-		//Selection
-		iY = top + (selected - firstElement) * fontheight;
-		if (selected<fl.size())
-			gmenu2x->s->box(1, iY, 309, fontheight, gmenu2x->skinConfColors[COLOR_SELECTION_BG]);
-
 		//Files & Dirs
-		gmenu2x->s->setClipRect(0, top, 311, height);
-		for (i = firstElement; i < fl.size()
-					&& i < firstElement + nb_elements; i++) {
-			iY = i-firstElement;
-			if (fl.isDirectory(i)) {
-				gmenu2x->sc["imgs/folder.png"]->blit(gmenu2x->s, 4, top + (iY * fontheight));
-				gmenu2x->s->write(gmenu2x->font, fl[i], 21,
-							top + (iY * fontheight) + (fontheight / 2),
-							Font::HAlignLeft, Font::VAlignMiddle);
-			} else
-				gmenu2x->s->write(gmenu2x->font, titles[i - fl.dirCount()], 4,
-							top + (iY * fontheight) + (fontheight / 2),
-							Font::HAlignLeft, Font::VAlignMiddle);
-		}
-		gmenu2x->s->clearClipRect();
+		list.paint(gmenu2x->s);
+
+		if (fl.isLoading())
+			gmenu2x->s->write(gmenu2x->font, gmenu2x->tr[loadingLabel],
+						310, top + height, Font::HAlignRight, Font::VAlignBottom);
 
-		gmenu2x->drawScrollBar(nb_elements, fl.size(), firstElement);
+		paintLetterOverlay();
 		gmenu2x->s->flip();
 
-		switch (gmenu2x->input.waitForPressedButton()) {
+		InputManager::Button button = gmenu2x->input.waitForPressedButton();
+		if (fl.size() == 0 && button != InputManager::SETTINGS
+					&& button != InputManager::CANCEL
+					&& button != InputManager::LEFT)
+			continue;
+		if (button != InputManager::REPAINT)
+			followStart = false;
+
+		switch (button) {
 			case InputManager::SETTINGS:
 				close = true;
 				result = false;
 				break;
 
 			case InputManager::UP:
-				if (selected == 0) selected = fl.size() -1;
-				else selected -= 1;
-				selTick = SDL_GetTicks();
+				list.up();
 				break;
 
 			case InputManager::ALTLEFT:
-				if ((int)(selected - nb_elements + 1) < 0)
-					selected = 0;
-				else
-					selected -= nb_elements - 1;
-				selTick = SDL_GetTicks();
+				list.setSelected(fl.prevLetter(selected));
+				showLetterOverlay(fl.getLetter(list.getSelected()));
 				break;
 
 			case InputManager::DOWN:
-				if (selected+1>=fl.size()) selected = 0;
-				else selected += 1;
-				selTick = SDL_GetTicks();
+				list.down();
 				break;
 
 			case InputManager::ALTRIGHT:
-				if (selected + nb_elements - 1 >= fl.size())
-					selected = fl.size() - 1;
-				else
-					selected += nb_elements - 1;
-				selTick = SDL_GetTicks();
+				list.setSelected(fl.nextLetter(selected));
+				showLetterOverlay(fl.getLetter(list.getSelected()));
 				break;
 
 			case InputManager::CANCEL:
@@ -190,9 +219,10 @@ int Selector::exec(int startSelection) {
 						result = false;
 					} else {
 						dir = dir.substr(0,p+1);
-						selected = 0;
-						firstElement = 0;
-						prepare(&fl,&screens,&titles);
+						startSelection = 0;
+						followStart = true;
+						prepare(&fl);
+						list.invalidate();
 					}
 				}
 				break;
@@ -207,9 +237,10 @@ int Selector::exec(int startSelection) {
 					dir = (string) buf + '/';
 					free(buf);
 
-					selected = 0;
-					firstElement = 0;
-					prepare(&fl,&screens,&titles);
+					startSelection = 0;
+					followStart = true;
+					prepare(&fl);
+					list.invalidate();
 				}
 				break;
 
@@ -218,70 +249,87 @@ int Selector::exec(int startSelection) {
 		}
 	}
 
-	gmenu2x->sc.defaultAlpha = true;
-	freeScreenshots(&screens);
+	screenshots.clear();
 
-	return result ? (int)selected : -1;
+	return result ? (int) list.getSelected() : -1;
 }
 
-void Selector::prepare(FileLister *fl, vector<string> *screens, vector<string> *titles) {
-	fl->setPath(dir);
-	freeScreenshots(screens);
-	screens->resize(fl->getFiles().size());
-	titles->resize(fl->getFiles().size());
+void Selector::prepare(FileLister *fl) {
+	screenshots.clear();
+	fileInfos.clear();
+	previews.clear();
+	previewsListed = false;
+	fl->setPath(dir, false);
+	fl->browseAsync();
+}
 
-	string screendir = dir;
-	if (screendir[screendir.length() - 1] != '/') {
-		screendir += "/";
-	}
-	screendir += "previews/";
-
-	string noext;
-	string::size_type pos;
-	for (uint i=0; i<fl->getFiles().size(); i++) {
-		noext = fl->getFiles()[i];
-		pos = noext.rfind(".");
-		if (pos!=string::npos && pos>0)
-			noext = noext.substr(0, pos);
-		titles->at(i) = getAlias(noext);
-		if (titles->at(i).empty())
-			titles->at(i) = noext;
-
-		DEBUG("Searching for screen '%s%s.png'\n", screendir.c_str(), noext.c_str());
-
-		if (fileExists(screendir+noext+".png"))
-			screens->at(i) = screendir+noext+".png";
-		else
-			screens->at(i) = "";
-	}
+const Selector::FileInfo &Selector::getFileInfo(const string &file) {
+	unordered_map<string, FileInfo>::iterator it = fileInfos.find(file);
+	if (it != fileInfos.end())
+		return it->second;
+
+	FileInfo &info = fileInfos[file];
+	string noext = file;
+	string::size_type pos = noext.rfind(".");
+	if (pos!=string::npos && pos>0)
+		noext = noext.substr(0, pos);
+	info.title = getAlias(noext);
+	if (info.title.empty())
+		info.title = noext;
+
+	if (!previewsListed)
+		listPreviews();
+	string name = noext + ".png";
+	transform(name.begin(), name.end(), name.begin(), ::tolower);
+	unordered_map<string, string>::iterator preview = previews.find(name);
+	if (preview != previews.end())
+		info.screen = dir + "previews/" + preview->second;
+
+	return info;
 }
 
-void Selector::freeScreenshots(vector<string> *screens) {
-	for (uint i=0; i<screens->size(); i++) {
-		if (!screens->at(i).empty())
-			gmenu2x->sc.del(screens->at(i));
+void Selector::listPreviews() {
+	previewsListed = true;
+
+	/* Most folders have no previews: check before asking the cache, which
+	 * would report the missing folder as an error. */
+	string previewDir = dir + "previews/";
+	struct stat st;
+	if (stat(previewDir.c_str(), &st) || !S_ISDIR(st.st_mode))
+		return;
+
+	shared_ptr<const DirListing> listing =
+				DirCache::getInstance().get(previewDir);
+	if (!listing)
+		return;
+
+	for (auto &file : listing->files) {
+		string name = file;
+		transform(name.begin(), name.end(), name.begin(), ::tolower);
+		if (name.size() > 4 && !name.compare(name.size() - 4, 4, ".png"))
+			previews[name] = file;
 	}
+	DEBUG("Found %u previews in '%s'\n",
+				(unsigned int) previews.size(), previewDir.c_str());
 }
 
-void Selector::loadAliases() {
-	aliases.clear();
-	if (fileExists(link->getAliasFile())) {
-		string line;
-		ifstream infile (link->getAliasFile().c_str(), ios_base::in);
-		while (getline(infile, line, '\n')) {
-			string::size_type position = line.find("=");
-			string name = trim(line.substr(0,position));
-			string value = trim(line.substr(position+1));
-			aliases[name] = value;
+void Selector::prefetchScreenshots(FileLister &fl, uint selected) {
+	/* The screenshot of the selected file comes first, then those of the
+	 * files around it, closest first. */
+	vector<string> paths;
+	for (int distance = 0; distance <= PREFETCH_DISTANCE; distance++) {
+		for (int sign = 1; sign >= (distance ? -1 : 1); sign -= 2) {
+			int i = (int) selected + sign * distance;
+			if (i < 0 || !fl.isFile(i))
+				continue;
+			const string &screen = getFileInfo(fl[i]).screen;
+			if (!screen.empty())
+				paths.push_back(screen);
 		}
-		infile.close();
 	}
+	screenshots.request(paths);
 }
 
 string Selector::getAlias(const string &key) {
-	unordered_map<string, string>::iterator i = aliases.find(key);
-	if (i == aliases.end())
-		return "";
-	else
-		return i->second;
+	return aliases ? aliases->lookup(key) : "";
 }
@@ -22,11 +22,15 @@
 #define SELECTOR_H
 
 #include "dialog.h"
+#include "previewcache.h"
+#include "translator.h"
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+class AliasIndex;
 class LinkApp;
 class FileLister;
 
@@ -35,13 +39,27 @@ private:
 	int selRow;
 	LinkApp *link;
 	std::string file, dir;
-	std::unordered_map<std::string, std::string> aliases;
+	std::shared_ptr<const AliasIndex> aliases;
 
-	void loadAliases();
+	/** What is shown for a file; looked up when it first becomes visible. */
+	struct FileInfo {
+		std::string title, screen;
+	};
+	std::unordered_map<std::string, FileInfo> fileInfos;
+
+	/** The images of the previews folder, by lower-case name. */
+	std::unordered_map<std::string, std::string> previews;
+	bool previewsListed;
+
+	PreviewCache screenshots;
+	Translator::Handle loadingLabel;
+
+	virtual void paintChrome(Surface *s);
 	std::string getAlias(const std::string &key);
-	void prepare(FileLister *fl, std::vector<std::string> *screens,
-			std::vector<std::string> *titles);
-	void freeScreenshots(std::vector<std::string> *screens);
+	void prepare(FileLister *fl);
+	const FileInfo &getFileInfo(const std::string &file);
+	void listPreviews();
+	void prefetchScreenshots(FileLister &fl, unsigned int selected);
 
 public:
 	Selector(GMenu2X *gmenu2x, LinkApp *link,
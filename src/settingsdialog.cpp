@@ -21,6 +21,8 @@
 #include "settingsdialog.h"
 
 #include "gmenu2x.h"
+#include "latencytrace.h"
+#include "listview.h"
 #include "menusetting.h"
 
 #include <SDL.h>
@@ -50,102 +52,77 @@ SettingsDialog::~SettingsDialog() {
 	}
 }
 
+void SettingsDialog::paintChrome(Surface *s) {
+	//link icon
+	drawTitleIcon(icon, false, s);
+	writeTitle(text, s);
+}
+
 bool SettingsDialog::exec() {
-	Surface bg(gmenu2x->bg);
-	bg.convertToDisplayFormat();
+	LatencyTrace::Scope scope("SettingsDialog");
 
 	bool close = false, ts_pressed = false;
-	uint i, sel = 0, firstElement = 0;
 
-	const int topBarHeight = gmenu2x->skinConfInt["topBarHeight"];
-	SDL_Rect clipRect = {
+	unsigned int top, height;
+	tie(top, height) = gmenu2x->getContentArea();
+	SDL_Rect area = {
 		0,
-		static_cast<Sint16>(topBarHeight + 1),
+		static_cast<Sint16>(top),
 		static_cast<Uint16>(gmenu2x->resX - 9),
-		static_cast<Uint16>(gmenu2x->resY - topBarHeight - 25)
+		static_cast<Uint16>(height)
 	};
-	SDL_Rect touchRect = {
-		2,
-		static_cast<Sint16>(topBarHeight + 4),
-		static_cast<Uint16>(gmenu2x->resX - 12),
-		static_cast<Uint16>(clipRect.h)
-	};
-	uint rowHeight = gmenu2x->font->getHeight() + 1; // gp2x=15+1 / pandora=19+1
-	uint numRows = (gmenu2x->resY - topBarHeight - 20) / rowHeight;
+
+	/* The settings draw their own rows, as their values change. */
+	ListView list(gmenu2x);
+	list.setArea(area, gmenu2x->font->getHeight() + 1); // gp2x=15+1 / pandora=19+1
+	list.setSelectionWidth(148);
+	list.setPainter([&](Surface *, uint i, int y) {
+		if (i == list.getSelected())
+			voices[i]->drawSelected(y);
+		voices[i]->draw(y);
+		return true;
+	});
+	list.setSize(voices.size());
 
 	while (!close) {
 		if (ts.available()) ts.poll();
 
-		bg.blit(gmenu2x->s,0,0);
-
-		gmenu2x->drawTopBar(gmenu2x->s);
-		//link icon
-		drawTitleIcon(icon);
-		writeTitle(text);
-
-		gmenu2x->drawBottomBar(gmenu2x->s);
-
-		if (sel>firstElement+numRows-1) firstElement=sel-numRows+1;
-		if (sel<firstElement) firstElement=sel;
+		getChrome()->blit(gmenu2x->s,0,0);
 
-		//selection
-		uint iY = topBarHeight + 2 + (sel - firstElement) * rowHeight;
-		gmenu2x->s->setClipRect(clipRect);
-		if (sel<voices.size()) {
-			gmenu2x->s->box(
-				1, iY, 148, rowHeight - 2,
-				gmenu2x->skinConfColors[COLOR_SELECTION_BG]
-			);
-		}
-		gmenu2x->s->clearClipRect();
-
-		//selected option
-		voices[sel]->drawSelected(iY);
-
-		gmenu2x->s->setClipRect(clipRect);
 		if (ts_pressed && !ts.pressed()) {
 			ts_pressed = false;
 		}
-		if (ts.available() && ts.pressed() && !ts.inRect(touchRect)) {
-			ts_pressed = false;
-		}
-		for (i=firstElement; i<voices.size() && i<firstElement+numRows; i++) {
-			iY = i-firstElement;
-			voices[i]->draw(iY * rowHeight + topBarHeight + 2);
-			if (ts.available() && ts.pressed() && ts.inRect(
-					touchRect.x, touchRect.y + (iY * rowHeight),
-					touchRect.w, rowHeight
-					)) {
+		if (ts.available() && ts.pressed()) {
+			int row = list.rowAt(ts.getX(), ts.getY());
+			if (row >= 0) {
 				ts_pressed = true;
-				sel = i;
+				list.setSelected(row);
+			} else {
+				ts_pressed = false;
 			}
 		}
-		gmenu2x->s->clearClipRect();
 
-		gmenu2x->drawScrollBar(numRows, voices.size(), firstElement);
+		list.paint(gmenu2x->s);
+
+		MenuSetting *sel = voices[list.getSelected()];
 
 		//description
-		writeSubTitle(voices[sel]->getDescription());
+		writeSubTitle(sel->getDescription());
 
 		gmenu2x->s->flip();
-		voices[sel]->handleTS();
+		sel->handleTS();
 
 		InputManager::Button button = inputMgr.waitForPressedButton();
-		if (!voices[sel]->handleButtonPress(button)) {
+		if (!sel->handleButtonPress(button)) {
 			switch (button) {
 				case InputManager::SETTINGS:
 					close = true;
 					break;
 				case InputManager::UP:
-					if (sel == 0) {
-						sel = voices.size() - 1;
-					} else {
-						sel -= 1;
-					}
+					list.up();
 					break;
 				case InputManager::DOWN:
-					sel += 1;
-					if (sel>=voices.size()) sel = 0;
+					list.down();
 				default:
 					break;
 			}
@@ -28,6 +28,7 @@
 
 class InputManager;
 class MenuSetting;
+class Surface;
 class Touchscreen;
 
 class SettingsDialog : protected Dialog {
@@ -37,6 +38,8 @@ private:
 	std::vector<MenuSetting *> voices;
 	std::string text, icon;
 
+	virtual void paintChrome(Surface *s);
+
 public:
 	SettingsDialog(GMenu2X *gmenu2x, InputManager &inputMgr, Touchscreen &ts,
 			const std::string &text,
@@ -0,0 +1,51 @@
+#include "stringpool.h"
+
+#include "debug.h"
+
+using namespace std;
+
+StringPool &StringPool::getInstance()
+{
+	static StringPool instance;
+	return instance;
+}
+
+StringPool::StringPool()
+	: requests(0)
+	, requestedBytes(0)
+	, storedBytes(0)
+{
+	strings.push_back("");
+}
+
+StringPool::Handle StringPool::intern(const string &str)
+{
+	if (str.empty())
+		return EMPTY;
+
+	requests++;
+	requestedBytes += sizeof(string) + str.size();
+
+	size_t hash = std::hash<string>()(str);
+	auto range = index.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (strings[it->second] == str)
+			return it->second;
+	}
+
+	Handle handle = strings.size();
+	strings.push_back(str);
+	index.insert(make_pair(hash, handle));
+	storedBytes += sizeof(string) + str.size()
+				+ sizeof(size_t) + sizeof(Handle);
+	return handle;
+}
+
+void StringPool::logStats() const
+{
+	INFO("String pool: %lu strings for %lu requests, "
+				"about %lu bytes instead of %lu\n",
+				(unsigned long) strings.size(), requests,
+				(unsigned long) storedBytes,
+				(unsigned long) requestedBytes);
+}
@@ -0,0 +1,90 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <cstddef>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Process-wide pool of immutable, deduplicated strings.
+ *
+ * Strings are referred to by small integer handles; handle 0 is always the
+ * empty string. Interned strings are never freed, so references returned
+ * by get() remain valid for the lifetime of the program.
+ *
+ * The pool is not thread-safe: it must only be used from the main thread.
+ */
+class StringPool {
+public:
+	typedef unsigned int Handle;
+	static const Handle EMPTY = 0;
+
+	static StringPool &getInstance();
+
+	/**
+	 * Returns the handle of the given string, adding it to the pool
+	 * if it was not there yet.
+	 */
+	Handle intern(const std::string &str);
+
+	const std::string &get(Handle handle) const { return strings[handle]; }
+
+	/**
+	 * Logs how many strings are stored and how much memory the
+	 * deduplication saved compared to storing every string separately.
+	 */
+	void logStats() const;
+
+private:
+	StringPool();
+
+	std::deque<std::string> strings;
+	std::unordered_multimap<size_t, Handle> index;
+
+	unsigned long requests;
+	size_t requestedBytes, storedBytes;
+};
+
+/**
+ * A string field stored as a handle into the StringPool: it takes the
+ * space of an int instead of a std::string, and equal values share a
+ * single copy. Assigning a new value interns it.
+ */
+class PooledString {
+public:
+	PooledString() : handle(StringPool::EMPTY) {}
+	PooledString(const std::string &str)
+		: handle(StringPool::getInstance().intern(str)) {}
+
+	PooledString &operator=(const std::string &str) {
+		handle = StringPool::getInstance().intern(str);
+		return *this;
+	}
+
+	const std::string &str() const {
+		return StringPool::getInstance().get(handle);
+	}
+	operator const std::string &() const { return str(); }
+
+	const char *c_str() const { return str().c_str(); }
+	bool empty() const { return handle == StringPool::EMPTY; }
+
+	bool operator==(const PooledString &other) const {
+		return handle == other.handle;
+	}
+	bool operator!=(const PooledString &other) const {
+		return handle != other.handle;
+	}
+
+private:
+	StringPool::Handle handle;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const PooledString &str)
+{
+	return os << str.str();
+}
+
+#endif
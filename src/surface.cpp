@@ -22,10 +22,13 @@
 
 #include "debug.h"
 #include "imageio.h"
+#include "latencytrace.h"
 #include "surfacecollection.h"
+#include "thumbnailcache.h"
 #include "utilities.h"
 
 #include <SDL_gfxPrimitives.h>
+#include <SDL_rotozoom.h>
 
 #include <iostream>
 
@@ -71,6 +74,18 @@ Surface *Surface::loadImage(const string &img, const string &skin, bool loadAlph
 	return new Surface(raw, true);
 }
 
+Surface *Surface::loadThumbnail(const string &img, int maxWidth, int maxHeight,
+		bool loadAlpha) {
+	SDL_Surface *raw =
+		ThumbnailCache::load(img, maxWidth, maxHeight, loadAlpha);
+	if (!raw) {
+		ERROR("Couldn't load thumbnail of '%s'\n", img.c_str());
+		return NULL;
+	}
+
+	return new Surface(raw, true);
+}
+
 Surface::Surface(SDL_Surface *raw_, bool freeWhenDone_)
 	: raw(raw_)
 	, freeWhenDone(freeWhenDone_)
@@ -80,15 +95,38 @@ Surface::Surface(SDL_Surface *raw_, bool freeWhenDone_)
 }
 
 Surface::Surface(Surface *s) {
-	raw = SDL_ConvertSurface(s->raw, s->raw->format, SDL_SWSURFACE);
+	raw = s->raw;
+	freeWhenDone = true;
+	halfW = raw->w/2;
+	halfH = raw->h/2;
+
+	if (s->freeWhenDone) {
+		// SDL_FreeSurface() only frees the pixels once the last
+		// reference is gone.
+		raw->refcount++;
+	} else {
+		// Not ours to share: the screen, for example, changes every
+		// frame.
+		copyPixels();
+	}
+}
+
+void Surface::copyPixels() const {
+	SDL_Surface *copy = SDL_ConvertSurface(raw, raw->format, SDL_SWSURFACE);
+	if (!copy) {
+		ERROR("Unable to copy surface: %s\n", SDL_GetError());
+		return;
+	}
 	// Note: A bug in SDL_ConvertSurface() leaves the per-surface alpha
 	//       undefined when converting from RGBA to RGBA. This can cause
 	//       problems if the surface is later converted to a format without
 	//       an alpha channel, such as the display format.
-	raw->format->alpha = s->raw->format->alpha;
+	copy->format->alpha = raw->format->alpha;
+	if (freeWhenDone) {
+		SDL_FreeSurface(raw);
+	}
+	raw = copy;
 	freeWhenDone = true;
-	halfW = raw->w/2;
-	halfH = raw->h/2;
 }
 
 Surface::~Surface() {
@@ -108,8 +146,16 @@ void Surface::convertToDisplayFormat() {
 	}
 }
 
+Surface *Surface::scaled(int width, int height) const {
+	SDL_Surface *zoomed = zoomSurface(raw,
+				(double) width / raw->w, (double) height / raw->h,
+				SMOOTHING_ON);
+	return zoomed ? new Surface(zoomed, true) : NULL;
+}
+
 void Surface::flip() {
 	SDL_Flip(raw);
+	LatencyTrace::getInstance().presented();
 }
 
 bool Surface::blit(SDL_Surface *destination, int x, int y, int w, int h, int a) const {
@@ -119,11 +165,14 @@ bool Surface::blit(SDL_Surface *destination, int x, int y, int w, int h, int a)
 	SDL_Rect dest;
 	dest.x = x;
 	dest.y = y;
-	if (a>0 && a!=raw->format->alpha)
+	if (a>0 && a!=raw->format->alpha) {
+		detach();
 		SDL_SetAlpha(raw, SDL_SRCALPHA|SDL_RLEACCEL, a);
+	}
 	return SDL_BlitSurface(raw, (w==0 || h==0) ? NULL : &src, destination, &dest);
 }
 bool Surface::blit(Surface *destination, int x, int y, int w, int h, int a) const {
+	destination->detach();
 	return blit(destination->raw,x,y,w,h,a);
 }
 
@@ -134,6 +183,7 @@ bool Surface::blitCenter(SDL_Surface *destination, int x, int y, int w, int h, i
 	return blit(destination,x-ow,y-oh,w,h,a);
 }
 bool Surface::blitCenter(Surface *destination, int x, int y, int w, int h, int a) const {
+	destination->detach();
 	return blitCenter(destination->raw,x,y,w,h,a);
 }
 
@@ -143,26 +193,31 @@ bool Surface::blitRight(SDL_Surface *destination, int x, int y, int w, int h, in
 }
 bool Surface::blitRight(Surface *destination, int x, int y, int w, int h, int a) const {
 	if (!w) w = raw->w;
+	destination->detach();
 	return blitRight(destination->raw,x,y,w,h,a);
 }
 
 int Surface::box(Sint16 x, Sint16 y, Uint16 w, Uint16 h, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	detach();
 	return boxRGBA(raw, x, y, x + w - 1, y + h - 1, r, g, b, a);
 }
 int Surface::box(Sint16 x, Sint16 y, Uint16 w, Uint16 h, Uint8 r, Uint8 g, Uint8 b) {
 	SDL_Rect re = { x, y, w, h };
+	detach();
 	return SDL_FillRect(raw, &re, SDL_MapRGBA(raw->format, r, g, b, 255));
 }
 int Surface::box(Sint16 x, Sint16 y, Uint16 w, Uint16 h, RGBAColor c) {
 	return box(x, y, w, h, c.r, c.g, c.b, c.a);
 }
 int Surface::box(SDL_Rect re, RGBAColor c) {
+	detach();
 	return boxRGBA(
 		raw, re.x, re.y, re.x + re.w - 1, re.y + re.h - 1, c.r, c.g, c.b, c.a
 		);
 }
 
 int Surface::rectangle(Sint16 x, Sint16 y, Uint16 w, Uint16 h, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	detach();
 	return rectangleRGBA(raw, x, y, x + w - 1, y + h - 1, r, g, b, a);
 }
 int Surface::rectangle(Sint16 x, Sint16 y, Uint16 w, Uint16 h, RGBAColor c) {
@@ -173,10 +228,13 @@ int Surface::rectangle(SDL_Rect re, RGBAColor c) {
 }
 
 int Surface::hline(Sint16 x, Sint16 y, Uint16 w, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	detach();
 	return hlineRGBA(raw, x, x + w - 1, y, r, g, b, a);
 }
 
+// The clip rectangle is part of the shared SDL_Surface too.
 void Surface::clearClipRect() {
+	detach();
 	SDL_SetClipRect(raw,NULL);
 }
 
@@ -189,6 +247,7 @@ void Surface::setClipRect(int x, int y, int w, int h) {
 }
 
 void Surface::setClipRect(SDL_Rect rect) {
+	detach();
 	SDL_SetClipRect(raw,&rect);
 }
 
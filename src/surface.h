@@ -42,7 +42,17 @@ public:
 	static Surface *emptySurface(int width, int height);
 	static Surface *loadImage(const std::string &img,
 			const std::string &skin="", bool loadAlpha=true);
-
+	/**
+	 * Loads an image shrunk to fit in the given size, from the thumbnail
+	 * cache if it is there. The image is never decoded at full size.
+	 */
+	static Surface *loadThumbnail(const std::string &img,
+			int maxWidth, int maxHeight, bool loadAlpha=false);
+
+	/**
+	 * Makes a copy of "s". The pixels are shared until either surface is
+	 * drawn on, so a copy that is only blitted never allocates a buffer.
+	 */
 	Surface(Surface *s);
 	~Surface();
 
@@ -55,6 +65,9 @@ public:
 	int width() const { return raw->w; }
 	int height() const { return raw->h; }
 
+	/** Returns a new copy of this surface, smoothly scaled to the given size. */
+	Surface *scaled(int width, int height) const;
+
 	void flip();
 
 	void clearClipRect();
@@ -83,12 +96,19 @@ public:
 
 private:
 	Surface(SDL_Surface *raw, bool freeWhenDone);
+	/**
+	 * Gives this surface its own pixels before they are changed, or
+	 * before the per-surface alpha is, which copies share as well.
+	 * The pixels stay the same, so this is allowed on a const surface.
+	 */
+	void detach() const { if (raw->refcount > 1) copyPixels(); }
+	void copyPixels() const;
 	bool blit(SDL_Surface *destination, int x, int y, int w=0, int h=0, int a=-1) const;
 	bool blitCenter(SDL_Surface *destination, int x, int y, int w=0, int h=0, int a=-1) const;
 	bool blitRight(SDL_Surface *destination, int x, int y, int w=0, int h=0, int a=-1) const;
 
-	SDL_Surface *raw;
-	bool freeWhenDone;
+	mutable SDL_Surface *raw;
+	mutable bool freeWhenDone;
 	int halfW, halfH;
 
 	// For direct access to "raw".
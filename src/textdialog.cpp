@@ -21,18 +21,34 @@
 #include "textdialog.h"
 
 #include "gmenu2x.h"
+#include "latencytrace.h"
 #include "utilities.h"
 
 using namespace std;
 
 TextDialog::TextDialog(GMenu2X *gmenu2x, const string &title, const string &description, const string &icon, vector<string> *text)
 	: Dialog(gmenu2x)
+	, lines(gmenu2x)
 {
 	this->text = text;
 	this->title = title;
 	this->description = description;
 	this->icon = icon;
 	preProcess();
+
+	lines.setCursor(false);
+	lines.setLabels([this](unsigned int i) { return (*shown)[i]; });
+	lines.setPainter([this](Surface *s, unsigned int i, int y) {
+		if ((*shown)[i] != "----")
+			return false;
+
+		// horizontal ruler
+		y += this->gmenu2x->font->getHeight() / 2;
+		s->hline(5, y, this->gmenu2x->resX - 16, 255, 255, 255, 130);
+		s->hline(5, y+1, this->gmenu2x->resX - 16, 0, 0, 0, 130);
+		return true;
+	});
+	showText(text);
 }
 
 void TextDialog::preProcess() {
@@ -77,76 +93,67 @@ void TextDialog::preProcess() {
 	}
 }
 
-void TextDialog::drawText(vector<string> *text, unsigned int y,
-		unsigned int firstRow, unsigned int rowsPerPage)
+void TextDialog::setTextArea(unsigned int y, unsigned int height)
 {
-	const int fontHeight = gmenu2x->font->getHeight();
-
-	for (unsigned i = firstRow; i < firstRow + rowsPerPage && i < text->size(); i++) {
-		const string &line = text->at(i);
-		int rowY = y + (i - firstRow) * fontHeight;
-		if (line == "----") { // horizontal ruler
-			rowY += fontHeight / 2;
-			gmenu2x->s->hline(5, rowY, gmenu2x->resX - 16, 255, 255, 255, 130);
-			gmenu2x->s->hline(5, rowY+1, gmenu2x->resX - 16, 0, 0, 0, 130);
-		} else {
-			gmenu2x->font->write(gmenu2x->s, line, 5, rowY);
-		}
-	}
-
-	gmenu2x->drawScrollBar(rowsPerPage, text->size(), firstRow);
+	lines.setArea((SDL_Rect) {
+		1,
+		static_cast<Sint16>(y),
+		static_cast<Uint16>(gmenu2x->resX - 10),
+		static_cast<Uint16>(height)
+	}, gmenu2x->font->getHeight());
 }
 
-void TextDialog::exec() {
-	bool close = false;
-
-	Surface bg(gmenu2x->bg);
+void TextDialog::showText(vector<string> *text)
+{
+	shown = text;
+	lines.setSize(text->size());
+	lines.setFirst(0);
+	lines.invalidate();
+}
 
+void TextDialog::paintChrome(Surface *s) {
 	//link icon
 	if (!fileExists(icon))
-		drawTitleIcon("icons/ebook.png",true,&bg);
+		drawTitleIcon("icons/ebook.png",true,s);
 	else
-		drawTitleIcon(icon,false,&bg);
-	writeTitle(title,&bg);
-	writeSubTitle(description,&bg);
+		drawTitleIcon(icon,false,s);
+	writeTitle(title,s);
+	writeSubTitle(description,s);
+
+	gmenu2x->drawButton(s, "start", gmenu2x->tr["Exit"],
+	gmenu2x->drawButton(s, "cancel", "",
+	gmenu2x->drawButton(s, "down", gmenu2x->tr["Scroll"],
+	gmenu2x->drawButton(s, "up", "", 5)-10))-10);
+}
 
-	gmenu2x->drawButton(&bg, "start", gmenu2x->tr["Exit"],
-	gmenu2x->drawButton(&bg, "cancel", "",
-	gmenu2x->drawButton(&bg, "down", gmenu2x->tr["Scroll"],
-	gmenu2x->drawButton(&bg, "up", "", 5)-10))-10);
+void TextDialog::exec() {
+	LatencyTrace::Scope scope("TextDialog");
 
-	bg.convertToDisplayFormat();
+	bool close = false;
 
 	const int fontHeight = gmenu2x->font->getHeight();
 	unsigned int contentY, contentHeight;
 	tie(contentY, contentHeight) = gmenu2x->getContentArea();
-	const unsigned rowsPerPage = contentHeight / fontHeight;
-	contentY += (contentHeight % fontHeight) / 2;
+	setTextArea(contentY + (contentHeight % fontHeight) / 2,
+				contentHeight - contentHeight % fontHeight);
 
-	unsigned firstRow = 0;
 	while (!close) {
-		bg.blit(gmenu2x->s, 0, 0);
-		drawText(text, contentY, firstRow, rowsPerPage);
+		getChrome()->blit(gmenu2x->s, 0, 0);
+		lines.paint(gmenu2x->s);
 		gmenu2x->s->flip();
 
 		switch(gmenu2x->input.waitForPressedButton()) {
 			case InputManager::UP:
-				if (firstRow > 0) firstRow--;
+				lines.up();
 				break;
 			case InputManager::DOWN:
-				if (firstRow + rowsPerPage < text->size()) firstRow++;
+				lines.down();
 				break;
 			case InputManager::ALTLEFT:
-				if (firstRow >= rowsPerPage-1) firstRow -= rowsPerPage-1;
-				else firstRow = 0;
+				lines.pageUp();
 				break;
 			case InputManager::ALTRIGHT:
-				if (firstRow + rowsPerPage*2 -1 < text->size()) {
-					firstRow += rowsPerPage-1;
-				} else {
-					firstRow = text->size() < rowsPerPage ?
-						0 : text->size() - rowsPerPage;
-				}
+				lines.pageDown();
 				break;
 			case InputManager::SETTINGS:
 			case InputManager::CANCEL:
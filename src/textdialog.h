@@ -22,6 +22,7 @@
 #define TEXTDIALOG_H
 
 #include "dialog.h"
+#include "listview.h"
 
 #include <string>
 #include <vector>
@@ -31,9 +32,16 @@ protected:
 	std::vector<std::string> *text;
 	std::string title, description, icon;
 
+	ListView lines;
+	/* The lines shown, either "text" or a part of it. */
+	std::vector<std::string> *shown;
+
 	void preProcess();
-	void drawText(std::vector<std::string> *text, unsigned int y,
-			unsigned int firstRow, unsigned int rowsPerPage);
+	virtual void paintChrome(Surface *s);
+	/** Places the lines between "y" and "y" + "height". */
+	void setTextArea(unsigned int y, unsigned int height);
+	/** Shows "text" from its first line; "----" lines are drawn as rulers. */
+	void showText(std::vector<std::string> *text);
 
 public:
 	TextDialog(GMenu2X *gmenu2x, const std::string &title,
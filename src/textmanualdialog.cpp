@@ -21,6 +21,7 @@
 #include "textmanualdialog.h"
 
 #include "gmenu2x.h"
+#include "latencytrace.h"
 #include "surface.h"
 #include "utilities.h"
 
@@ -67,74 +68,74 @@ TextManualDialog::TextManualDialog(GMenu2X *gmenu2x, const string &title, const
 	}
 }
 
-void TextManualDialog::exec() {
-	bool close = false;
-	uint page=0;
-
-	Surface bg(gmenu2x->bg);
-
+void TextManualDialog::paintChrome(Surface *s) {
 	//link icon
 	if (!fileExists(icon))
-		drawTitleIcon("icons/ebook.png",true,&bg);
+		drawTitleIcon("icons/ebook.png",true,s);
 	else
-		drawTitleIcon(icon,false,&bg);
-	writeTitle(title+(description.empty() ? "" : ": "+description),&bg);
+		drawTitleIcon(icon,false,s);
+	writeTitle(title+(description.empty() ? "" : ": "+description),s);
+
+	gmenu2x->drawButton(s, "start", gmenu2x->tr["Exit"],
+	gmenu2x->drawButton(s, "cancel", "",
+	gmenu2x->drawButton(s, "right", gmenu2x->tr["Change page"],
+	gmenu2x->drawButton(s, "left", "",
+	gmenu2x->drawButton(s, "down", gmenu2x->tr["Scroll"],
+	gmenu2x->drawButton(s, "up", "", 5)-10))-10))-10);
+}
 
-	gmenu2x->drawButton(&bg, "start", gmenu2x->tr["Exit"],
-	gmenu2x->drawButton(&bg, "cancel", "",
-	gmenu2x->drawButton(&bg, "right", gmenu2x->tr["Change page"],
-	gmenu2x->drawButton(&bg, "left", "",
-	gmenu2x->drawButton(&bg, "down", gmenu2x->tr["Scroll"],
-	gmenu2x->drawButton(&bg, "up", "", 5)-10))-10))-10);
+void TextManualDialog::exec() {
+	LatencyTrace::Scope scope("TextManualDialog");
 
-	bg.convertToDisplayFormat();
+	bool close = false;
+	uint page=0;
 
-	uint firstRow = 0, rowsPerPage = 180/gmenu2x->font->getHeight();
+	setTextArea(42 /* TODO */, 180);
+	showText(&pages[page].text);
 	stringstream ss;
 	ss << pages.size();
 	string spagecount;
 	ss >> spagecount;
 	string pageStatus;
+	const string &pageLabel = gmenu2x->tr["Page"];
 
 	while (!close) {
-		bg.blit(gmenu2x->s,0,0);
+		getChrome()->blit(gmenu2x->s,0,0);
 		writeSubTitle(pages[page].title);
-		drawText(&pages[page].text, 42 /* TODO */, firstRow, rowsPerPage);
+		lines.paint(gmenu2x->s);
 
 		ss.clear();
 		ss << page+1;
 		ss >> pageStatus;
-		pageStatus = gmenu2x->tr["Page"]+": "+pageStatus+"/"+spagecount;
+		pageStatus = pageLabel+": "+pageStatus+"/"+spagecount;
 		gmenu2x->s->write(gmenu2x->font, pageStatus, 310, 230, Font::HAlignRight, Font::VAlignMiddle);
 
 		gmenu2x->s->flip();
 
 		switch(gmenu2x->input.waitForPressedButton()) {
 			case InputManager::UP:
-				if (firstRow > 0) firstRow--;
+				lines.up();
 				break;
 			case InputManager::DOWN:
-				if (firstRow + rowsPerPage < pages[page].text.size()) firstRow++;
+				lines.down();
 				break;
 			case InputManager::LEFT:
 				if (page > 0) {
 					page--;
-					firstRow = 0;
+					showText(&pages[page].text);
 				}
 				break;
 			case InputManager::RIGHT:
 				if (page < pages.size() -1) {
 					page++;
-					firstRow = 0;
+					showText(&pages[page].text);
 				}
 				break;
 			case InputManager::ALTLEFT:
-				if (firstRow >= rowsPerPage-1) firstRow -= rowsPerPage-1;
-				else firstRow = 0;
+				lines.pageUp();
 				break;
 			case InputManager::ALTRIGHT:
-				if (firstRow + rowsPerPage*2 -1 < pages[page].text.size()) firstRow += rowsPerPage-1;
-				else firstRow = max(0ul, (unsigned long) (pages[page].text.size() - rowsPerPage));
+				lines.pageDown();
 				break;
 			case InputManager::CANCEL:
 			case InputManager::SETTINGS:
@@ -35,6 +35,8 @@ class TextManualDialog : public TextDialog {
 private:
 	std::vector<ManualPage> pages;
 
+	virtual void paintChrome(Surface *s);
+
 public:
 	TextManualDialog(GMenu2X *gmenu2x, const std::string &title,
 			const std::string &icon, std::vector<std::string> *text);
@@ -0,0 +1,268 @@
+#include "thumbnailcache.h"
+
+#include "debug.h"
+#include "gmenu2x.h"
+#include "imageio.h"
+
+#include <SDL.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <dirent.h>
+#include <functional>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+/* Once the thumbnails take more than this, the least recently used are
+ * removed until they take half. */
+static const off_t MAX_CACHE_SIZE = 16 * 1024 * 1024;
+
+/* The modification time of a thumbnail is the last time it was used, but
+ * it is only updated when it is this old, to spare the card some writes. */
+static const time_t TOUCH_INTERVAL = 60 * 60;
+
+static const char MAGIC[4] = { 'G', 'M', 'T', '1' };
+
+/* Starts every cache file; it is followed by the path of the image and
+ * then by the pixels, row after row. */
+struct Header {
+	int64_t mtimeSec, mtimeNsec, size;
+	char magic[4];
+	uint32_t maxWidth, maxHeight, alpha;
+	uint32_t pathLength, width, height;
+};
+
+static pthread_once_t initOnce = PTHREAD_ONCE_INIT;
+static bool writable = false;
+
+// Guards the size of the cache, and its pruning.
+static pthread_mutex_t sizeMutex = PTHREAD_MUTEX_INITIALIZER;
+static off_t cacheSize = 0;
+
+static string cacheDir()
+{
+	return GMenu2X::getHome() + "/thumbnails/";
+}
+
+static bool isFromSameImage(const Header &a, const Header &b)
+{
+	return equal(a.magic, a.magic + sizeof(a.magic), b.magic)
+		&& a.mtimeSec == b.mtimeSec && a.mtimeNsec == b.mtimeNsec
+		&& a.size == b.size && a.maxWidth == b.maxWidth
+		&& a.maxHeight == b.maxHeight && a.alpha == b.alpha
+		&& a.pathLength == b.pathLength;
+}
+
+static SDL_Surface *createSurface(unsigned int width, unsigned int height,
+		bool loadAlpha)
+{
+	// Same format as the surfaces made by loadPNG().
+	return SDL_CreateRGBSurface(
+		SDL_SWSURFACE | SDL_SRCALPHA, width, height, 32,
+		0x00FF0000, 0x0000FF00, 0x000000FF, loadAlpha ? 0xFF000000 : 0x00000000
+		);
+}
+
+static SDL_Surface *readThumbnail(
+		const string &file, const Header &key, const string &path)
+{
+	FILE *fp = fopen(file.c_str(), "rb");
+	if (!fp)
+		return NULL;
+
+	SDL_Surface *surface = NULL;
+	Header header;
+	string storedPath(key.pathLength, '\0');
+	if (fread(&header, sizeof(header), 1, fp) == 1
+			&& isFromSameImage(header, key)
+			&& header.width && header.width <= 65536
+			&& header.height && header.height <= 2048
+			&& fread(&storedPath[0], storedPath.size(), 1, fp) == 1
+			&& storedPath == path) {
+		surface = createSurface(header.width, header.height, key.alpha);
+	}
+
+	if (surface) {
+		Uint8 *row = static_cast<Uint8 *>(surface->pixels);
+		for (int y = 0; y < surface->h; y++, row += surface->pitch) {
+			if (fread(row, surface->w * 4, 1, fp) != 1) {
+				WARNING("Truncated thumbnail '%s'\n", file.c_str());
+				SDL_FreeSurface(surface);
+				surface = NULL;
+				break;
+			}
+		}
+	}
+
+	struct stat st;
+	if (surface && !fstat(fileno(fp), &st)
+			&& st.st_mtime + TOUCH_INTERVAL < time(NULL))
+		futimens(fileno(fp), NULL);
+
+	fclose(fp);
+	return surface;
+}
+
+struct CacheFile {
+	string name;
+	time_t mtime;
+	off_t size;
+};
+
+/* Removes the least recently used thumbnails if the cache is too large, and
+ * recounts its size. Call with sizeMutex held. Only the first call, made
+ * before any thumbnail is written, removes the temporary files left behind
+ * by writes that did not complete. */
+static void prune(bool removeTemporary)
+{
+	const string dir = cacheDir();
+	DIR *dirp = opendir(dir.c_str());
+	if (!dirp)
+		return;
+
+	vector<CacheFile> files;
+	off_t total = 0;
+	struct dirent *dptr;
+	while ((dptr = readdir(dirp))) {
+		if (dptr->d_name[0] == '.')
+			continue;
+
+		const string name = dir + dptr->d_name;
+		struct stat st;
+		if (stat(name.c_str(), &st) || !S_ISREG(st.st_mode))
+			continue;
+
+		if (name.size() < 6 || name.compare(name.size() - 6, 6, ".thumb")) {
+			if (removeTemporary)
+				unlink(name.c_str());
+			continue;
+		}
+
+		CacheFile file = { name, st.st_mtime, st.st_size };
+		files.push_back(file);
+		total += st.st_size;
+	}
+	closedir(dirp);
+
+	if (total > MAX_CACHE_SIZE) {
+		sort(files.begin(), files.end(),
+				[](const CacheFile &a, const CacheFile &b) {
+					return a.mtime < b.mtime;
+				});
+		unsigned int removed = 0;
+		for (auto &file : files) {
+			if (total <= MAX_CACHE_SIZE / 2)
+				break;
+			if (!unlink(file.name.c_str())) {
+				total -= file.size;
+				removed++;
+			}
+		}
+		INFO("Removed %u old thumbnails\n", removed);
+	}
+	cacheSize = total;
+}
+
+static void init()
+{
+	const string dir = cacheDir();
+	if (mkdir(dir.c_str(), 0770) < 0 && errno != EEXIST) {
+		WARNING("Unable to create thumbnail directory '%s'\n", dir.c_str());
+		return;
+	}
+	writable = true;
+
+	pthread_mutex_lock(&sizeMutex);
+	prune(true);
+	pthread_mutex_unlock(&sizeMutex);
+}
+
+static void writeThumbnail(const string &file, Header header,
+		const string &path, SDL_Surface *surface)
+{
+	pthread_once(&initOnce, init);
+	if (!writable)
+		return;
+
+	// Written under a temporary name, so that another thread or a crash
+	// never leaves a partial file under the real one.
+	string tmp = file + ".XXXXXX";
+	int fd = mkstemp(&tmp[0]);
+	if (fd < 0) {
+		WARNING("Unable to create thumbnail '%s'\n", file.c_str());
+		return;
+	}
+	FILE *fp = fdopen(fd, "wb");
+	if (!fp) {
+		close(fd);
+		unlink(tmp.c_str());
+		return;
+	}
+
+	header.width = surface->w;
+	header.height = surface->h;
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+		&& fwrite(path.data(), path.size(), 1, fp) == 1;
+
+	const Uint8 *row = static_cast<const Uint8 *>(surface->pixels);
+	for (int y = 0; ok && y < surface->h; y++, row += surface->pitch)
+		ok = fwrite(row, surface->w * 4, 1, fp) == 1;
+
+	ok = !fclose(fp) && ok;
+	if (!ok || rename(tmp.c_str(), file.c_str())) {
+		WARNING("Unable to write thumbnail '%s'\n", file.c_str());
+		unlink(tmp.c_str());
+		return;
+	}
+
+	/* A thumbnail that replaced an outdated one is counted twice, which
+	 * only makes the next recount come a little early. */
+	pthread_mutex_lock(&sizeMutex);
+	cacheSize += sizeof(header) + path.size()
+			+ (off_t) surface->w * surface->h * 4;
+	if (cacheSize > MAX_CACHE_SIZE)
+		prune(false);
+	pthread_mutex_unlock(&sizeMutex);
+}
+
+SDL_Surface *ThumbnailCache::load(const string &path,
+		unsigned int maxWidth, unsigned int maxHeight, bool loadAlpha)
+{
+	// Icons inside an OPK package change along with the package.
+	const string image = path.substr(0, path.find('#'));
+	struct stat st;
+	if (stat(image.c_str(), &st) || !S_ISREG(st.st_mode))
+		return loadPNGThumbnail(path, maxWidth, maxHeight, loadAlpha);
+
+	Header key = Header();
+	key.mtimeSec = st.st_mtim.tv_sec;
+	key.mtimeNsec = st.st_mtim.tv_nsec;
+	key.size = st.st_size;
+	copy(MAGIC, MAGIC + sizeof(MAGIC), key.magic);
+	key.maxWidth = maxWidth;
+	key.maxHeight = maxHeight;
+	key.alpha = loadAlpha;
+	key.pathLength = path.size();
+
+	char name[64];
+	snprintf(name, sizeof(name), "%lx-%ux%u%s.thumb",
+			(unsigned long) hash<string>()(path),
+			maxWidth, maxHeight, loadAlpha ? "a" : "");
+	const string file = cacheDir() + name;
+
+	SDL_Surface *surface = readThumbnail(file, key, path);
+	if (surface)
+		return surface;
+
+	surface = loadPNGThumbnail(path, maxWidth, maxHeight, loadAlpha);
+	if (surface)
+		writeThumbnail(file, key, path, surface);
+	return surface;
+}
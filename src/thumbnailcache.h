@@ -0,0 +1,34 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <string>
+
+struct SDL_Surface;
+
+/**
+ * Shrunk copies of PNG images, stored uncompressed in the gmenu2x home
+ * directory so that showing an image again costs a file read instead of
+ * a PNG decode.
+ *
+ * A thumbnail is found by the path of its image and the size it was shrunk
+ * to fit in, and is used for as long as the image keeps its modification
+ * time and size. When the cache grows too large, the thumbnails that were
+ * used least recently are removed.
+ *
+ * Can be used from any thread.
+ */
+class ThumbnailCache {
+public:
+	/**
+	 * Returns the image at "path" shrunk like loadPNGThumbnail() does,
+	 * from the cache if possible; a thumbnail that had to be decoded is
+	 * added to the cache. Returns NULL if the image cannot be loaded.
+	 */
+	static SDL_Surface *load(const std::string &path,
+			unsigned int maxWidth, unsigned int maxHeight, bool loadAlpha);
+
+private:
+	ThumbnailCache();
+};
+
+#endif
@@ -24,9 +24,6 @@
 #include "gmenu2x.h"
 #include "utilities.h"
 
-#include <fstream>
-#include <iostream>
-#include <sstream>
 #include <stdarg.h>
 
 using namespace std;
@@ -40,62 +37,117 @@ Translator::Translator(const string &lang) {
 Translator::~Translator() {}
 
 bool Translator::exists(const string &term) {
-	return translations.find(term) != translations.end();
+	return find(term) != nullptr;
 }
 
 void Translator::setLang(const string &lang) {
-	translations.clear();
+	entries.clear();
+	segments.clear();
+	catalog.reset();
+	cache.clear();
+	missing.clear();
 
-	string line;
-	ifstream infile ((GMenu2X::getHome() + "/translations/" + lang).c_str(), ios_base::in);
-	if (!infile.is_open())
-	  infile.open((string(GMENU2X_SYSTEM_DIR "/translations/") + lang).c_str(), ios_base::in);
-
-	if (infile.is_open()) {
-		while (getline(infile, line, '\n')) {
-			line = trim(line);
-			if (line.empty()) continue;
-			if (line[0]=='#') continue;
-
-			string::size_type position = line.find("=");
-			translations[ trim(line.substr(0,position)) ] = trim(line.substr(position+1));
-		}
-		infile.close();
+	if (lang.empty()) {
 		_lang = lang;
+	} else {
+		string path = GMenu2X::getHome() + "/translations/" + lang;
+		if (!fileExists(path))
+			path = GMENU2X_SYSTEM_DIR "/translations/" + lang;
+
+		catalog.reset(new ConfReader(path));
+		if (catalog->isOpen()) {
+			StrRef name, value;
+			while (catalog->next(name, value)) {
+				Entry entry = { segments.size(), 0 };
+				parse(value, segments);
+				entry.count = segments.size() - entry.first;
+				entries[name] = entry;
+			}
+			_lang = lang;
+		} else {
+			catalog.reset();
+		}
 	}
-}
 
-string Translator::translate(const string &term,const char *replacestr,...) {
-	string result = term;
+	for (auto &it : interned)
+		it.text = translate(it.term);
+}
 
-	if (!_lang.empty()) {
-		unordered_map<string, string>::iterator i = translations.find(term);
-		if (i != translations.end()) {
-			result = i->second;
-		}
+void Translator::parse(StrRef text, vector<Segment> &out) {
+	size_t start = 0;
+	for (size_t i = 0; i + 1 < text.size(); i++) {
+		if (text[i] != '$' || text[i + 1] < '1' || text[i + 1] > '9')
+			continue;
+
+		if (i > start)
+			out.push_back({ text.substr(start, i - start), 0 });
+		out.push_back({ text.substr(i, 2), text[i + 1] - '0' });
+		start = i + 2;
+		i++;
+	}
+	if (start < text.size() || out.empty())
+		out.push_back({ text.substr(start), 0 });
+}
 
-		else WARNING("Untranslated string: '%s'\n", term.c_str());
+string Translator::expand(const Segment *segments, size_t count,
+		const vector<const char *> &args) {
+	string result;
+	for (size_t i = 0; i < count; i++) {
+		const Segment &seg = segments[i];
+		if (seg.arg > 0 && (size_t) seg.arg <= args.size())
+			result += args[seg.arg - 1];
+		else
+			result.append(seg.text.data(), seg.text.size());
 	}
+	return result;
+}
 
+const Translator::Entry *Translator::find(const string &term) {
+	auto it = entries.find(StrRef(term.data(), term.size()));
+	return it == entries.end() ? nullptr : &it->second;
+}
+
+string Translator::translate(const string &term,const char *replacestr,...) {
+	vector<const char *> args;
 	va_list arglist;
 	va_start(arglist, replacestr);
-	const char *param = replacestr;
-	int argnum = 1;
-	while (param!=NULL) {
-		string id = "";
-		stringstream ss; ss << argnum; ss >> id;
-		result = strreplace(result,"$"+id,param);
-
-		param = va_arg(arglist,const char*);
-		argnum++;
-	}
+	for (const char *param = replacestr; param; param = va_arg(arglist, const char*))
+		args.push_back(param);
 	va_end(arglist);
 
-	return result;
+	const Entry *entry = nullptr;
+	if (!_lang.empty()) {
+		entry = find(term);
+		if (!entry && missing.insert(term).second)
+			WARNING("Untranslated string: '%s'\n", term.c_str());
+	}
+
+	if (entry)
+		return expand(&segments[entry->first], entry->count, args);
+	if (args.empty())
+		return term;
+
+	vector<Segment> parsed;
+	parse(StrRef(term.data(), term.size()), parsed);
+	return expand(parsed.data(), parsed.size(), args);
 }
 
-string Translator::operator[](const string &term) {
-	return translate(term);
+const string &Translator::operator[](const string &term) {
+	auto it = cache.find(term);
+	if (it == cache.end())
+		it = cache.emplace(term, translate(term)).first;
+	return it->second;
+}
+
+Translator::Handle Translator::intern(const string &term) {
+	auto it = handles.find(term);
+	if (it != handles.end())
+		return it->second;
+
+	Handle handle = interned.size();
+	interned.push_back({ term, translate(term) });
+	handles[term] = handle;
+	return handle;
 }
 
 string Translator::lang() {
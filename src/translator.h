@@ -21,20 +21,32 @@
 #ifndef TRANSLATOR_H
 #define TRANSLATOR_H
 
+#include "confreader.h"
+
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 /**
 Hash Map of translation strings.
 
+The translation file stays mapped for as long as the language is in use:
+terms and translations point into it, and every translation is split into
+its literal parts and its "$n" placeholders when the file is loaded.
+
 	@author Massimiliano Torromeo <massimiliano.torromeo@gmail.com>
 */
 class Translator {
-private:
-	std::string _lang;
-	std::unordered_map<std::string, std::string> translations;
-
 public:
+	/**
+	 * Identifies a term returned by intern(). Handles stay valid when the
+	 * language changes, so they can be obtained once and used on every
+	 * frame without hashing the term again.
+	 */
+	typedef unsigned int Handle;
+
 	Translator(const std::string &lang="");
 	~Translator();
 
@@ -43,7 +55,48 @@ public:
 	bool exists(const std::string &term);
 	std::string translate(const std::string &term,
 			const char *replacestr = NULL, ...);
-	std::string operator[](const std::string &term);
+
+	/**
+	 * Returns the translation of "term". The reference is valid until the
+	 * language is changed.
+	 */
+	const std::string &operator[](const std::string &term);
+
+	Handle intern(const std::string &term);
+	const std::string &operator[](Handle handle) {
+		return interned[handle].text;
+	}
+
+private:
+	/** A literal piece of a translation, or a "$n" placeholder if arg > 0. */
+	struct Segment {
+		StrRef text;
+		int arg;
+	};
+	/** The range of "segments" that makes up one translation. */
+	struct Entry {
+		size_t first, count;
+	};
+	struct Interned {
+		std::string term, text;
+	};
+
+	static void parse(StrRef text, std::vector<Segment> &out);
+	static std::string expand(const Segment *segments, size_t count,
+			const std::vector<const char *> &args);
+
+	const Entry *find(const std::string &term);
+
+	std::string _lang;
+	std::unique_ptr<ConfReader> catalog;
+	std::unordered_map<StrRef, Entry, StrRefHash> entries;
+	std::vector<Segment> segments;
+
+	std::unordered_map<std::string, std::string> cache;
+	std::unordered_set<std::string> missing;
+
+	std::vector<Interned> interned;
+	std::unordered_map<std::string, Handle> handles;
 };
 
 #endif // TRANSLATOR_H
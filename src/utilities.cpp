@@ -31,15 +31,10 @@
 #include <dirent.h>
 #include <fstream>
 #include <iostream>
-#include <strings.h>
 #include <unistd.h>
 
 using namespace std;
 
-bool case_less::operator()(const string &left, const string &right) const {
-	return strcasecmp(left.c_str(), right.c_str()) < 0;
-}
-
 // General tool to strip spaces from both ends:
 string trim(const string& s) {
   if(s.length() == 0)
@@ -108,15 +103,6 @@ int evalIntConf (int val, int def, int imin, int imax) {
 	val = constrain(val, imin, imax);
 	return val;
 }
-int evalIntConf (ConfIntHash& hash, const std::string &key, int def, int imin, int imax) {
-	if (hash.find(key) == hash.end()) {
-		hash[key] = def;
-		return def;
-	} else {
-		hash[key] = constrain(hash[key], imin, imax);
-		return hash[key];
-	}
-}
 
 bool split (vector<string> &vec, const string &str, const string &delim, bool destructive) {
 	vec.clear();
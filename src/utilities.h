@@ -27,11 +27,6 @@
 #include "gmenu2x.h"
 #include "inputmanager.h"
 
-class case_less {
-public:
-	bool operator()(const std::string &left, const std::string &right) const;
-};
-
 std::string trim(const std::string& s);
 std::string strreplace(std::string orig, const std::string &search, const std::string &replace);
 std::string cmdclean(std::string cmdline);
@@ -43,7 +38,6 @@ bool rmtree(std::string path);
 int constrain(int x, int imin, int imax);
 
 int evalIntConf(int val, int def, int imin, int imax);
-int evalIntConf(ConfIntHash& hash, const std::string &key, int def, int imin, int imax);
 
 bool split(std::vector<std::string> &vec, const std::string &str,
 		const std::string &delim, bool destructive=true);
@@ -25,10 +25,14 @@
 #include "filelister.h"
 #include "gmenu2x.h"
 #include "iconbutton.h"
+#include "latencytrace.h"
+#include "listview.h"
+#include "previewcache.h"
 #include "surface.h"
 #include "utilities.h"
 
 #include <iostream>
+#include <memory>
 
 using namespace std;
 
@@ -40,24 +44,26 @@ WallpaperDialog::WallpaperDialog(GMenu2X *gmenu2x, Touchscreen &ts_)
 
 bool WallpaperDialog::exec()
 {
+	LatencyTrace::Scope scope("WallpaperDialog");
+
 	bool close = false, result = true;
 
 	FileLister fl;
 	fl.setFilter("png");
 
 	string filepath = GMenu2X::getHome() + "/skins/"
-	  	+ gmenu2x->confStr["skin"] + "/wallpapers";
+	  	+ gmenu2x->conf.skin + "/wallpapers";
 	if (fileExists(filepath))
 	  fl.setPath(filepath, true);
 
 	filepath = GMENU2X_SYSTEM_DIR "/skins/"
-	  	+ gmenu2x->confStr["skin"] + "/wallpapers";
+	  	+ gmenu2x->conf.skin + "/wallpapers";
 	if (fileExists(filepath)) {
 		fl.setPath(filepath, false);
 		fl.browse(false);
 	}
 
-	if (gmenu2x->confStr["skin"] != "Default") {
+	if (gmenu2x->conf.skin != "Default") {
 		filepath = GMenu2X::getHome() + "/skins/Default/wallpapers";
 		if (fileExists(filepath)) {
 			fl.setPath(filepath, false);
@@ -75,7 +81,9 @@ bool WallpaperDialog::exec()
 
 	DEBUG("Wallpapers: %i\n", wallpapers.size());
 
-	uint i, selected = 0, firstElement = 0, iY;
+	vector<string> paths;
+	for (auto &name : wallpapers)
+		paths.push_back(gmenu2x->sc.getSkinFilePath("wallpapers/" + name));
 
 	ButtonBox buttonbox(gmenu2x);
 	buttonbox.add(new IconButton(gmenu2x, ts, "skin:imgs/buttons/accept.png", gmenu2x->tr["Select wallpaper"]));
@@ -84,17 +92,71 @@ bool WallpaperDialog::exec()
 	unsigned int top, height;
 	tie(top, height) = gmenu2x->getContentArea();
 
-	int fontheight = gmenu2x->font->getHeight();
-	unsigned int nb_elements = height / fontheight;
+	/* Thumbnails are loaded in the background at a fraction of the screen
+	 * size, from the thumbnail cache when possible, and kept in the
+	 * surface collection for the next time; only the selected wallpaper
+	 * is decoded at full size. */
+	const int thumbWidth = gmenu2x->resX / 8, thumbHeight = gmenu2x->resY / 8;
+	PreviewCache thumbnails([=](const string &path) {
+		return Surface::loadThumbnail(path, thumbWidth, thumbHeight);
+	});
+	PreviewCache fullSize;
+	auto thumbnailOf = [&](uint i) -> Surface * {
+		const string key = "thumb:" + paths[i];
+		return gmenu2x->sc.exists(key) ? gmenu2x->sc[key] : nullptr;
+	};
+
+	/* Shown while the selected wallpaper is being decoded. */
+	unique_ptr<Surface> placeholder;
+	uint placeholderFor = 0;
+
+	ListView list(gmenu2x);
+	list.setArea((SDL_Rect) {
+		0, static_cast<Sint16>(top), 311, static_cast<Uint16>(height)
+	}, max(gmenu2x->font->getHeight(), thumbHeight + 2));
+	list.setLabels([&](uint i) { return wallpapers[i]; });
+	list.setIcons(thumbnailOf);
+	list.setSize(wallpapers.size());
 
 	while (!close) {
-		if (selected > firstElement + nb_elements - 1)
-			firstElement = selected - nb_elements + 1;
-		if (selected < firstElement)
-			firstElement = selected;
+		const uint selected = list.getSelected();
+
+		/* Keep the thumbnails loaded since the last frame, and ask for
+		 * the missing ones, closest to the cursor first. Wallpapers that
+		 * cannot be decoded are left without thumbnail. */
+		vector<string> missing;
+		for (uint distance = 0; distance < paths.size(); distance++) {
+			for (int sign = 1; sign >= (distance ? -1 : 1); sign -= 2) {
+				int i = (int) selected + sign * (int) distance;
+				if (i < 0 || i >= (int) paths.size() || thumbnailOf(i))
+					continue;
+				Surface *thumbnail = thumbnails.take(paths[i]);
+				if (thumbnail)
+					gmenu2x->sc.add(thumbnail, "thumb:" + paths[i]);
+				else if (!thumbnails.hasFailed(paths[i]))
+					missing.push_back(paths[i]);
+			}
+		}
+		thumbnails.request(missing);
 
 		//Wallpaper
-		gmenu2x->sc[((string)"skin:wallpapers/" + wallpapers[selected]).c_str()]->blit(gmenu2x->s, 0, 0);
+		Surface *image = nullptr;
+		if (selected < paths.size()) {
+			fullSize.request(vector<string>(1, paths[selected]));
+			image = fullSize.get(paths[selected]);
+			if (!image) {
+				if (placeholderFor != selected)
+					placeholder.reset();
+				Surface *thumbnail = thumbnailOf(selected);
+				if (!placeholder && thumbnail) {
+					placeholder.reset(thumbnail->scaled(
+								gmenu2x->resX, gmenu2x->resY));
+					placeholderFor = selected;
+				}
+				image = placeholder.get();
+			}
+		}
+		(image ? image : gmenu2x->bg)->blit(gmenu2x->s, 0, 0);
 
 		gmenu2x->drawTopBar(gmenu2x->s);
 		gmenu2x->drawBottomBar(gmenu2x->s);
@@ -105,23 +167,8 @@ bool WallpaperDialog::exec()
 
 		buttonbox.paint(gmenu2x->s, 5);
 
-		//Selection
-		iY = selected - firstElement;
-		iY = top + (iY * fontheight);
-		gmenu2x->s->box(2, iY, 308, fontheight, gmenu2x->skinConfColors[COLOR_SELECTION_BG]);
-
 		//Files & Directories
-		gmenu2x->s->setClipRect(0, top, 311, height);
-		for (i = firstElement; i < wallpapers.size()
-					&& i < firstElement + nb_elements; i++) {
-			iY = i-firstElement;
-			gmenu2x->s->write(gmenu2x->font, wallpapers[i], 5,
-						top + (iY * fontheight),
-						Font::HAlignLeft, Font::VAlignTop);
-		}
-		gmenu2x->s->clearClipRect();
-
-		gmenu2x->drawScrollBar(nb_elements, wallpapers.size(), firstElement);
+		list.paint(gmenu2x->s);
 		gmenu2x->s->flip();
 
         switch(gmenu2x->input.waitForPressedButton()) {
@@ -130,37 +177,26 @@ bool WallpaperDialog::exec()
                 result = false;
                 break;
             case InputManager::UP:
-                if (selected == 0) selected = wallpapers.size()-1;
-                else selected -= 1;
+                list.up();
                 break;
             case InputManager::ALTLEFT:
-                if ((int)(selected - nb_elements + 1) < 0)
-					selected = 0;
-                else
-					selected -= nb_elements - 1;
+                list.pageUp();
                 break;
             case InputManager::DOWN:
-                if (selected+1 >= wallpapers.size()) selected = 0;
-                else selected += 1;
+                list.down();
                 break;
             case InputManager::ALTRIGHT:
-                if (selected + nb_elements - 1 >= wallpapers.size())
-					selected = wallpapers.size() - 1;
-                else
-					selected += nb_elements - 1;
+                list.pageDown();
                 break;
             case InputManager::ACCEPT:
                 close = true;
                 if (wallpapers.size() > 0)
-					wallpaper = gmenu2x->sc.getSkinFilePath("wallpapers/" + wallpapers[selected]);
+					wallpaper = paths[selected];
                 else result = false;
             default:
                 break;
         }
 	}
 
-	for (uint i=0; i<wallpapers.size(); i++)
-	  gmenu2x->sc.del("skin:wallpapers/" + wallpapers[i]);
-
 	return result;
 }